@@ -4,10 +4,13 @@
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
+#include <sys/mman.h>
+#include "../utils/Utils.hpp"
+#include "../utils/Trace.hpp"
 
 ELFWriter::ELFWriter(const std::string &outputFile,
                      SymbolTable &symbolTable,
-                     std::unordered_map<std::string, std::vector<Section>> &segSecTable,
+                     std::unordered_map<Atom, std::vector<Section>> &segSecTable,
                      RelocationTable &relocationTable)
     : outputFile(outputFile), symbolTable(symbolTable), segSecTable(segSecTable), relocationTable(relocationTable), fd(-1), elf(nullptr)
 {
@@ -21,7 +24,9 @@ void ELFWriter::initElf()
     throw std::runtime_error("ELF 库初始化失败");
   }
 
-  fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  // libelf 需要可随机写的 fd；输出到标准输出时先写到匿名内存文件，结束时一次拷出
+  toStdout = outputFile == "-";
+  fd = toStdout ? memfd_create("elf-output", 0) : open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
   if (fd < 0)
   {
     throw std::runtime_error("无法打开输出文件");
@@ -58,7 +63,7 @@ void ELFWriter::createElfHeader()
   }
 }
 
-size_t ELFWriter::addToShStrTab(const std::string &str)
+size_t ELFWriter::addToShStrTab(std::string_view str)
 {
   size_t offset = shstrtabData.size();
   shstrtabData.insert(shstrtabData.end(), str.begin(), str.end());
@@ -66,7 +71,7 @@ size_t ELFWriter::addToShStrTab(const std::string &str)
   return offset;
 }
 
-size_t ELFWriter::addToStrTab(const std::string &str)
+size_t ELFWriter::addToStrTab(std::string_view str)
 {
   size_t offset = strtabData.size();
   strtabData.insert(strtabData.end(), str.begin(), str.end());
@@ -119,7 +124,8 @@ void ELFWriter::createSections()
   // 基于 segSecTable 创建段
   for (const auto &segEntry : segSecTable)
   {
-    const std::string &segmentName = segEntry.first;
+    Atom segmentId = segEntry.first;
+    std::string segmentName(StringPool::str(segmentId));
     const std::vector<Section> &sections = segEntry.second;
 
     // 跳过空的段
@@ -185,7 +191,7 @@ void ELFWriter::createSections()
     uint32_t segmentOffset = 0; // 段内偏移
 
     // 用于记录每个 section 在段内的起始偏移
-    std::unordered_map<std::string, uint32_t> sectionBaseAddressMap;
+    std::unordered_map<Atom, uint32_t> sectionBaseAddressMap;
 
     for (const Section &section : sections)
     {
@@ -197,7 +203,7 @@ void ELFWriter::createSections()
 
       // 记录当前 section 在段内的起始偏移
       uint32_t sectionOffsetInSegment = segmentOffset;
-      sectionBaseAddressMap[section.getName()] = sectionOffsetInSegment;
+      sectionBaseAddressMap[section.getNameId()] = sectionOffsetInSegment;
 
       // 添加 section 数据
       const std::vector<uint8_t> &data = section.getData();
@@ -228,14 +234,15 @@ void ELFWriter::createSections()
     {
       throw std::runtime_error("gelf_update_shdr() 更新 " + segmentName + " 失败");
     }
+    TRACE(Elf, Info, segmentName << "：" << sections.size() << " 个节，" << shdr.sh_size << " 字节，文件偏移 " << shdr.sh_offset);
 
     // 更新符号地址
-    for (auto &symbolPair : symbolTable.getSymbols())
+    for (SymbolId id = 0; id < symbolTable.size(); id++)
     {
-      Symbol &symbol = symbolPair.second;
-      if (symbol.getSegmentName() == segmentName)
+      Symbol &symbol = symbolTable[id];
+      if (symbol.getSegmentId() == segmentId)
       {
-        const std::string &sectionName = symbol.getSectionName();
+        Atom sectionName = symbol.getSectionId();
         uint32_t symbolSectionOffset = symbol.getInSecAddress(); // 符号在节内的偏移
 
         // 获取 section 在段内的基地址
@@ -251,7 +258,7 @@ void ELFWriter::createSections()
     fileOffset += shdr.sh_size;
 
     // 将段名映射到 Elf_Scn
-    sectionMap[segmentName] = scn;
+    sectionMap[segmentId] = scn;
   }
 
   // 更新 .shstrtab 段数据
@@ -349,43 +356,79 @@ void ELFWriter::createSymbolTable()
   memset(&sym, 0, sizeof(GElf_Sym));
   symbols.push_back(sym);
 
-  // 从符号表中添加符号
-  size_t localSymbolCount = 1; // 从 1 开始计数（跳过未定义符号）
-  for (const auto &symEntry : symbolTable.getSymbols())
+  // 被重定位项引用的符号：.L 开头的局部标签只有这时才写进 .symtab
+  std::vector<uint8_t> referenced(symbolTable.size(), 0);
+  for (uint32_t section = 0; section < relocationTable.sectionCount(); section++)
   {
-    const std::string &symName = symEntry.first;
-    const Symbol &symbol = symEntry.second;
+    for (const RelocationEntry &rel : relocationTable.getRelocations(section))
+    {
+      referenced[rel.symbol] = 1;
+    }
+  }
+
+  // 从符号表中添加符号：ELF 要求局部符号在前，sh_info 为第一个全局符号的下标。
+  // 只被重定位项引用过的符号（外部符号）按未定义的全局符号输出
+  symbolIndices.assign(symbolTable.size(), 0);
+  auto isGlobalSymbol = [this](SymbolId id)
+  {
+    return symbolTable[id].isGlobal() || symbolTable[id].isReferenceOnly();
+  };
+  auto addSymbol = [&](SymbolId id)
+  {
+    const Symbol &symbol = symbolTable[id];
+    std::string_view symName = StringPool::str(symbolTable.getName(id));
+    if (!referenced[id] && !symbol.isGlobal() && symName.size() > 2 && symName[0] == '.' && symName[1] == 'L')
+    {
+      return;
+    }
 
     memset(&sym, 0, sizeof(GElf_Sym));
     size_t nameOffset = addToStrTab(symName);
     sym.st_name = nameOffset;
-    sym.st_value = symbol.getSAddress();
-    sym.st_size = symbol.getSize();
-    sym.st_info = GELF_ST_INFO(symbol.isGlobal() ? STB_GLOBAL : STB_LOCAL,
-                               symbol.getType() == SymbolType::FUNCTION ? STT_FUNC : STT_OBJECT);
-
-    // 获取段索引
-    const std::string &sectionName = symbol.getSectionName();
-    if (sectionName.empty())
+    if (symbol.isReferenceOnly())
     {
-      sym.st_shndx = SHN_UNDEF; // 未定义
+      sym.st_info = GELF_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+      sym.st_shndx = SHN_UNDEF;
     }
     else
     {
-      if (sectionMap.find(sectionName) == sectionMap.end())
+      sym.st_value = symbol.getSAddress();
+      sym.st_size = symbolTable.getSymbolSize(id);
+      sym.st_info = GELF_ST_INFO(symbol.isGlobal() ? STB_GLOBAL : STB_LOCAL,
+                                 symbol.getType() == SymbolType::FUNCTION ? STT_FUNC : STT_OBJECT);
+
+      // 获取段索引
+      Atom sectionName = symbol.getSectionId();
+      if (sectionName == 0)
       {
-        throw std::runtime_error("找不到符号所在的段：" + symName);
+        sym.st_shndx = SHN_UNDEF; // 未定义
+      }
+      else
+      {
+        if (sectionMap.find(sectionName) == sectionMap.end())
+        {
+          throw std::runtime_error("找不到符号所在的段：" + std::string(symName));
+        }
+        sym.st_shndx = elf_ndxscn(sectionMap[sectionName]);
       }
-      sym.st_shndx = elf_ndxscn(sectionMap[sectionName]);
     }
 
     symbols.push_back(sym);
-    size_t symbolIndex = symbols.size() - 1;
-    symbolIndices[symName] = symbolIndex;
-
-    if (!symbol.isGlobal())
+    symbolIndices[id] = static_cast<uint32_t>(symbols.size() - 1);
+  };
+  for (SymbolId id = 0; id < symbolTable.size(); id++)
+  {
+    if (!isGlobalSymbol(id))
+    {
+      addSymbol(id);
+    }
+  }
+  size_t localSymbolCount = symbols.size(); // 含第 0 个未定义符号
+  for (SymbolId id = 0; id < symbolTable.size(); id++)
+  {
+    if (isGlobalSymbol(id))
     {
-      localSymbolCount++;
+      addSymbol(id);
     }
   }
 
@@ -425,20 +468,19 @@ void ELFWriter::createSymbolTable()
 
 void ELFWriter::createRelocationSections()
 {
-  // 遍历重定位表，创建相应的重定位段
-  const auto &relocationsMap = relocationTable.getRelocations();
-
-  for (const auto &relEntry : relocationsMap)
+  // 遍历重定位表，每个有重定位项的段创建相应的重定位段
+  for (uint32_t index = 0; index < relocationTable.sectionCount(); index++)
   {
-    const std::string &sectionName = relEntry.first; // 重定位目标段名，例如 ".text"
-    const std::vector<RelocationEntry> &relocations = relEntry.second;
+    Atom sectionId = relocationTable.getSectionName(index); // 重定位目标段名，例如 ".text"
+    std::string sectionName(StringPool::str(sectionId));
+    const std::vector<RelocationEntry> &relocations = relocationTable.getRelocations(index);
 
     // 获取目标段的 Elf_Scn
-    if (sectionMap.find(sectionName) == sectionMap.end())
+    if (sectionMap.find(sectionId) == sectionMap.end())
     {
       throw std::runtime_error("找不到重定位目标段：" + sectionName);
     }
-    Elf_Scn *targetScn = sectionMap[sectionName];
+    Elf_Scn *targetScn = sectionMap[sectionId];
 
     // 创建重定位段，例如 ".rel.text"
     std::string relSectionName = ".rel" + sectionName;
@@ -467,29 +509,13 @@ void ELFWriter::createRelocationSections()
       throw std::runtime_error("gelf_update_shdr() 更新重定位段失败：" + relSectionName);
     }
 
-    // 准备重定位条目
-    std::vector<GElf_Rel> rels;
-    for (const RelocationEntry &rel : relocations)
+    // 准备重定位条目：符号句柄直接换算成符号表下标，不需要查表
+    std::vector<GElf_Rel> rels(relocations.size());
+    for (size_t i = 0; i < relocations.size(); i++)
     {
-      GElf_Rel gelfRel;
-      memset(&gelfRel, 0, sizeof(GElf_Rel));
-      gelfRel.r_offset = rel.offset;
-
-      // 获取符号在符号表中的索引
-      auto symIt = symbolIndices.find(rel.symbolName);
-      if (symIt != symbolIndices.end())
-      {
-        size_t symIndex = symIt->second;
-
-        // 构建 r_info，注意需要将 rel.type 转换为整数类型
-        gelfRel.r_info = GELF_R_INFO(symIndex, static_cast<uint32_t>(rel.type));
-
-        rels.push_back(gelfRel);
-      }
-      else
-      {
-        throw std::runtime_error("重定位引用了未知符号：" + rel.symbolName);
-      }
+      const RelocationEntry &rel = relocations[i];
+      rels[i].r_offset = rel.offset;
+      rels[i].r_info = GELF_R_INFO(symbolIndices[rel.symbol], static_cast<uint32_t>(rel.type));
     }
 
     // 写入重定位段数据
@@ -508,7 +534,7 @@ void ELFWriter::createRelocationSections()
     }
 
     // 将重定位段名映射到 Elf_Scn（可选，如果需要在其他地方使用）
-    sectionMap[relSectionName] = relScn;
+    sectionMap[StringPool::intern(relSectionName)] = relScn;
   }
 }
 
@@ -526,6 +552,17 @@ void ELFWriter::finalize()
   {
     throw std::runtime_error("elf_end() 失败");
   }
+  if (toStdout)
+  {
+    off_t size = lseek(fd, 0, SEEK_END);
+    std::vector<char> buffer(size > 0 ? size : 0);
+    if (pread(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size()) ||
+        !Utils::writeFully(STDOUT_FILENO, buffer.data(), buffer.size()))
+    {
+      close(fd);
+      throw std::runtime_error("写入标准输出失败");
+    }
+  }
   close(fd);
 }
 
@@ -535,6 +572,7 @@ void ELFWriter::write()
   createSections();
   createSymbolTable();
   createRelocationSections(); // 处理重定位表
+  TRACE(Elf, Info, "写入 " << outputFile);
   writeToFile();
   finalize();
 }
@@ -4,6 +4,7 @@
 #define ELF_WRITER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <cstdint>
@@ -20,7 +21,7 @@ class ELFWriter
 public:
   ELFWriter(const std::string &outputFile,
             SymbolTable &symbolTable,
-            std::unordered_map<std::string, std::vector<Section>> &segSecTable,
+            std::unordered_map<Atom, std::vector<Section>> &segSecTable,
             RelocationTable &relocationTable);
 
   void write();
@@ -35,16 +36,17 @@ private:
   void finalize();
 
   // 辅助函数
-  size_t addToStrTab(const std::string &str);
-  size_t addToShStrTab(const std::string &str);
+  size_t addToStrTab(std::string_view str);
+  size_t addToShStrTab(std::string_view str);
 
 private:
   std::string outputFile;
   SymbolTable &symbolTable;
-  std::unordered_map<std::string, std::vector<Section>> &segSecTable;
+  std::unordered_map<Atom, std::vector<Section>> &segSecTable;
   RelocationTable &relocationTable; // 引用重定位表
 
   int fd;
+  bool toStdout = false; // outputFile 为 "-"
   Elf *elf;
   GElf_Ehdr ehdr;
 
@@ -58,9 +60,9 @@ private:
   std::vector<char> strtabData;   // 字符串表的数据，存储所有符号名
 
   // 从段名到 Elf_Scn（ELF 段的句柄） 的映射
-  std::unordered_map<std::string, Elf_Scn *> sectionMap;
-  // 从符号名到符号表索引的映射
-  std::unordered_map<std::string, size_t> symbolIndices;
+  std::unordered_map<Atom, Elf_Scn *> sectionMap;
+  // 符号句柄 -> .symtab 中的下标
+  std::vector<uint32_t> symbolIndices;
 };
 
 #endif // ELF_WRITER_HPP
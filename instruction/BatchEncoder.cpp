@@ -0,0 +1,207 @@
+// instruction/BatchEncoder.cpp
+
+#include "BatchEncoder.hpp"
+#include "Encoding.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_ENCODER_X86 1
+#endif
+
+namespace
+{
+  // 运行时按格式分派到 packInstruction（伪指令没有位布局，返回 0）
+  constexpr uint32_t packByFormat(const OpcodeInfo &info, uint32_t rd, uint32_t rs1, uint32_t rs2, int32_t imm)
+  {
+    switch (info.format)
+    {
+    case Format::I:
+      return packInstruction<Format::I>(info, rd, rs1, rs2, imm);
+    case Format::L:
+      return packInstruction<Format::L>(info, rd, rs1, rs2, imm);
+    case Format::R:
+      return packInstruction<Format::R>(info, rd, rs1, rs2, imm);
+    case Format::S:
+      return packInstruction<Format::S>(info, rd, rs1, rs2, imm);
+    case Format::B:
+      return packInstruction<Format::B>(info, rd, rs1, rs2, imm);
+    case Format::U:
+      return packInstruction<Format::U>(info, rd, rs1, rs2, imm);
+    case Format::J:
+      return packInstruction<Format::J>(info, rd, rs1, rs2, imm);
+    case Format::M:
+      return packInstruction<Format::M>(info, rd, rs1, rs2, imm);
+    default:
+      return 0;
+    }
+  }
+
+  // 按操作码编号查的三张表，由操作码表在编译期生成：
+  // base 为寄存器和立即数全 0 时的指令字（opcode/funct3/funct7），
+  // registerMask 为该格式寄存器字段所占的位，immKind 决定立即数的位布局
+  struct FieldTables
+  {
+    uint32_t base[OpcodeTable::COUNT];
+    uint32_t registerMask[OpcodeTable::COUNT];
+    uint32_t immKind[OpcodeTable::COUNT];
+  };
+
+  constexpr FieldTables buildTables()
+  {
+    FieldTables tables{};
+    for (size_t i = 0; i < OpcodeTable::COUNT; i++)
+    {
+      const OpcodeInfo &info = OpcodeTable::entries[i];
+      tables.base[i] = packByFormat(info, 0, 0, 0, 0);
+      tables.registerMask[i] = packByFormat(info, 0x1F, 0x1F, 0x1F, 0) ^ tables.base[i];
+      tables.immKind[i] = static_cast<uint32_t>(info.immKind);
+    }
+    return tables;
+  }
+
+  constexpr FieldTables tables = buildTables();
+
+  static_assert(tables.registerMask[static_cast<size_t>(Opcode::Add)] == 0x01FF8F80, "R 型使用 rd/rs1/rs2");
+  static_assert(tables.registerMask[static_cast<size_t>(Opcode::Sw)] == 0x01FF8000, "S 型使用 rs1/rs2");
+  static_assert(tables.registerMask[static_cast<size_t>(Opcode::Lui)] == 0x00000F80, "U 型只使用 rd");
+
+#ifdef BATCH_ENCODER_X86
+  __attribute__((target("avx2"))) inline __m256i mask(uint32_t bits)
+  {
+    return _mm256_set1_epi32(static_cast<int>(bits));
+  }
+
+  // 8 个字节零扩展到 8 个 32 位通道
+  __attribute__((target("avx2"))) inline __m256i loadBytes(const uint8_t *p)
+  {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+  }
+
+  // 每轮 8 条：字段装入 8 个 32 位通道，opcode 相关的常量用 gather 按操作码编号查表，
+  // 五种立即数布局都算出来，再按 immKind 选取。位运算与 Encoding.hpp 中的 packInstruction 逐项对应
+  __attribute__((target("avx2"))) void encodeAVX2(const uint8_t *op, const uint8_t *rd, const uint8_t *rs1, const uint8_t *rs2, const int32_t *imm, size_t count, uint32_t *out)
+  {
+    const int *baseTable = reinterpret_cast<const int *>(tables.base);
+    const int *maskTable = reinterpret_cast<const int *>(tables.registerMask);
+    const int *kindTable = reinterpret_cast<const int *>(tables.immKind);
+    const __m256i registerBits = mask(0x1F);
+    const __m256i kindI12 = _mm256_set1_epi32(static_cast<int>(ImmKind::I12));
+    const __m256i kindS12 = _mm256_set1_epi32(static_cast<int>(ImmKind::S12));
+    const __m256i kindB13 = _mm256_set1_epi32(static_cast<int>(ImmKind::B13));
+    const __m256i kindU20 = _mm256_set1_epi32(static_cast<int>(ImmKind::U20));
+    const __m256i kindJ21 = _mm256_set1_epi32(static_cast<int>(ImmKind::J21));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      __m256i ops = loadBytes(op + i);
+      __m256i rdv = _mm256_and_si256(loadBytes(rd + i), registerBits);
+      __m256i rs1v = _mm256_and_si256(loadBytes(rs1 + i), registerBits);
+      __m256i rs2v = _mm256_and_si256(loadBytes(rs2 + i), registerBits);
+      __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(imm + i));
+
+      __m256i word = _mm256_i32gather_epi32(baseTable, ops, 4);
+      __m256i registerMask = _mm256_i32gather_epi32(maskTable, ops, 4);
+      __m256i kind = _mm256_i32gather_epi32(kindTable, ops, 4);
+
+      // 寄存器字段：rd 7-11，rs1 15-19，rs2 20-24，不用的字段由 registerMask 清掉
+      __m256i registers = _mm256_or_si256(_mm256_slli_epi32(rdv, 7),
+                                          _mm256_or_si256(_mm256_slli_epi32(rs1v, 15), _mm256_slli_epi32(rs2v, 20)));
+      word = _mm256_or_si256(word, _mm256_and_si256(registers, registerMask));
+
+      // I/L: imm[11:0] -> 20-31
+      __m256i immI = _mm256_slli_epi32(bits, 20);
+      // S: imm[4:0] -> 7-11，imm[11:5] -> 25-31
+      __m256i immS = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(bits, mask(0x1F)), 7),
+                                     _mm256_and_si256(_mm256_slli_epi32(bits, 20), mask(0xFE000000)));
+      // B: 沿用原有布局，以半字偏移拆分
+      __m256i half = _mm256_srli_epi32(bits, 1);
+      __m256i immB = _mm256_or_si256(
+          _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(half, 4), mask(0x1)), 7),
+                          _mm256_slli_epi32(_mm256_and_si256(half, mask(0xF)), 8)),
+          _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(half, 5), mask(0x3F)), 25),
+                          _mm256_slli_epi32(_mm256_srli_epi32(half, 11), 31)));
+      // U: imm[19:0] -> 12-31
+      __m256i immU = _mm256_slli_epi32(bits, 12);
+      // J: imm[19:12] -> 12-19，imm[11] -> 20，imm[10:1] -> 21-30，imm[20] -> 31
+      __m256i immJ = _mm256_or_si256(
+          _mm256_or_si256(_mm256_and_si256(bits, mask(0x000FF000)),
+                          _mm256_and_si256(_mm256_slli_epi32(bits, 9), mask(0x00100000))),
+          _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(bits, 20), mask(0x7FE00000)),
+                          _mm256_and_si256(_mm256_slli_epi32(bits, 11), mask(0x80000000))));
+
+      __m256i immediate = _mm256_and_si256(_mm256_cmpeq_epi32(kind, kindI12), immI);
+      immediate = _mm256_or_si256(immediate, _mm256_and_si256(_mm256_cmpeq_epi32(kind, kindS12), immS));
+      immediate = _mm256_or_si256(immediate, _mm256_and_si256(_mm256_cmpeq_epi32(kind, kindB13), immB));
+      immediate = _mm256_or_si256(immediate, _mm256_and_si256(_mm256_cmpeq_epi32(kind, kindU20), immU));
+      immediate = _mm256_or_si256(immediate, _mm256_and_si256(_mm256_cmpeq_epi32(kind, kindJ21), immJ));
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_or_si256(word, immediate));
+    }
+    // 清掉 ymm 高半部分再回到 SSE 代码，否则之后的每条 SSE 指令都要付出状态切换的代价
+    _mm256_zeroupper();
+    BatchEncoder::encodeScalar(op + i, rd + i, rs1 + i, rs2 + i, imm + i, count - i, out + i);
+  }
+#endif
+}
+
+bool BatchEncoder::accepts(const Instruction &instruction)
+{
+  if (instruction.symbol != 0 || instruction.function != ImmFunction::None)
+  {
+    return false;
+  }
+  const OpcodeInfo &info = OpcodeTable::info(instruction.op);
+  switch (info.format)
+  {
+  case Format::R:
+  case Format::M:
+  case Format::L: // 取数指令的偏移不检查范围，按低 12 位截断
+    return true;
+  case Format::I:
+  case Format::S:
+  case Format::U:
+    return OpcodeTable::fitsImmediate(info.immKind, instruction.imm);
+  case Format::B:
+    return instruction.imm % 2 == 0 && OpcodeTable::fitsImmediate(info.immKind, instruction.imm);
+  case Format::J:
+    return instruction.imm % 4 == 0 && OpcodeTable::fitsImmediate(info.immKind, instruction.imm);
+  default:
+    return false;
+  }
+}
+
+void BatchEncoder::encodeScalar(const uint8_t *op, const uint8_t *rd, const uint8_t *rs1, const uint8_t *rs2, const int32_t *imm, size_t count, uint32_t *out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = packByFormat(OpcodeTable::entries[op[i]], rd[i], rs1[i], rs2[i], imm[i]);
+  }
+}
+
+bool BatchEncoder::hasAVX2()
+{
+#ifdef BATCH_ENCODER_X86
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+void BatchEncoder::encode(const uint8_t *op, const uint8_t *rd, const uint8_t *rs1, const uint8_t *rs2, const int32_t *imm, size_t count, uint32_t *out)
+{
+#ifdef BATCH_ENCODER_X86
+  if (hasAVX2())
+  {
+    encodeAVX2(op, rd, rs1, rs2, imm, count, out);
+    return;
+  }
+#endif
+  encodeScalar(op, rd, rs1, rs2, imm, count, out);
+}
+
+void BatchEncoder::encode(const InstructionBatch &batch, uint32_t *out)
+{
+  encode(batch.op.data(), batch.rd.data(), batch.rs1.data(), batch.rs2.data(), batch.imm.data(), batch.size(), out);
+}
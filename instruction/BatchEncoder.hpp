@@ -0,0 +1,67 @@
+// instruction/BatchEncoder.hpp
+
+#ifndef BATCH_ENCODER_HPP
+#define BATCH_ENCODER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Instruction.hpp"
+
+// 一批已解码指令的字段，按结构数组（SoA）存放：各字段连续，便于一次装入 8 条
+struct InstructionBatch
+{
+  std::vector<uint8_t> op;
+  std::vector<uint8_t> rd;
+  std::vector<uint8_t> rs1;
+  std::vector<uint8_t> rs2;
+  std::vector<int32_t> imm; // 已解析的立即数；B/J 型为字节偏移
+
+  void push(Opcode opcode, uint8_t rdValue, uint8_t rs1Value, uint8_t rs2Value, int32_t immValue)
+  {
+    op.push_back(static_cast<uint8_t>(opcode));
+    rd.push_back(rdValue);
+    rs1.push_back(rs1Value);
+    rs2.push_back(rs2Value);
+    imm.push_back(immValue);
+  }
+
+  void push(const Instruction &instruction)
+  {
+    push(instruction.op, instruction.rd, instruction.rs1, instruction.rs2, instruction.imm);
+  }
+
+  void clear()
+  {
+    op.clear();
+    rd.clear();
+    rs1.clear();
+    rs2.clear();
+    imm.clear();
+  }
+
+  size_t size() const { return op.size(); }
+};
+
+// 批量编码：字段已全部确定（不引用符号）、每条编码为一个字的指令，
+// 一次处理一整段，每条的结果与 Instruction::encode 完全相同。
+// 运行时检测 CPU：支持 AVX2 时每轮打包 8 条（含 B/J 型立即数的位拆分），否则逐条用标量版本
+class BatchEncoder
+{
+public:
+  // 能否批量编码：不是伪指令，没有符号和 %function，立即数满足该格式的范围和对齐要求
+  // （不满足时由 Instruction::encode 按原样报错）
+  static bool accepts(const Instruction &instruction);
+
+  // 编码 count 条指令，第 i 条写入 out[i]。调用方保证每条都满足 accepts 的条件
+  static void encode(const uint8_t *op, const uint8_t *rd, const uint8_t *rs1, const uint8_t *rs2, const int32_t *imm, size_t count, uint32_t *out);
+  static void encode(const InstructionBatch &batch, uint32_t *out);
+
+  // 标量版本（也用于处理不足 8 条的尾部）
+  static void encodeScalar(const uint8_t *op, const uint8_t *rd, const uint8_t *rs1, const uint8_t *rs2, const int32_t *imm, size_t count, uint32_t *out);
+
+  // 当前 CPU 是否走 AVX2 路径
+  static bool hasAVX2();
+};
+
+#endif // BATCH_ENCODER_HPP
@@ -0,0 +1,90 @@
+// instruction/EncodeCache.cpp
+
+#include "EncodeCache.hpp"
+#include "../utils/Utils.hpp"
+
+EncodeCache &EncodeCache::shared()
+{
+  static EncodeCache cache;
+  return cache;
+}
+
+uint32_t EncodeCache::find(const TokenArena &arena, const LexedLine &line)
+{
+  // 规范化：去掉词法单元之间的空白，"addi\tsp, sp, -32" 与 "addi sp,sp,-32" 得到同一个键
+  key.clear();
+  for (const Token *token = arena.begin(line); token != arena.end(line); ++token)
+  {
+    key += arena.text(*token);
+    key += '\n';
+  }
+  keyHash = Utils::hashBytes(key);
+
+  if (!slots.empty())
+  {
+    size_t mask = slots.size() - 1;
+    for (size_t slot = keyHash & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+      uint32_t index = slots[slot] - 1;
+      if (hashes[index] == keyHash && keys[index] == key)
+      {
+        hits++;
+        return index;
+      }
+    }
+  }
+  misses++;
+  return NO_ENTRY;
+}
+
+uint32_t EncodeCache::insert(const Instruction &instruction)
+{
+  if (instruction.symbol != 0 || instruction.function != ImmFunction::None || entries.size() >= MAX_ENTRIES)
+  {
+    return NO_ENTRY;
+  }
+
+  Entry entry;
+  entry.instruction = instruction;
+  try
+  {
+    entry.count = static_cast<uint32_t>(instruction.encode(0, entry.words, noFixups));
+  }
+  catch (const std::exception &)
+  {
+    return NO_ENTRY; // 编码出错（如立即数越界）的行不缓存，第二遍编码时照常报错
+  }
+
+  // 装载因子保持在 1/2 以下
+  if ((entries.size() + 1) * 2 > slots.size())
+  {
+    grow();
+  }
+  uint32_t index = static_cast<uint32_t>(entries.size());
+  entries.push_back(entry);
+  keys.push_back(key);
+  hashes.push_back(keyHash);
+  size_t mask = slots.size() - 1;
+  size_t slot = keyHash & mask;
+  while (slots[slot] != 0)
+  {
+    slot = (slot + 1) & mask;
+  }
+  slots[slot] = index + 1;
+  return index;
+}
+
+void EncodeCache::grow()
+{
+  slots.assign(slots.empty() ? 1024 : slots.size() * 2, 0);
+  size_t mask = slots.size() - 1;
+  for (uint32_t index = 0; index < entries.size(); index++)
+  {
+    size_t slot = hashes[index] & mask;
+    while (slots[slot] != 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = index + 1;
+  }
+}
@@ -0,0 +1,58 @@
+// instruction/EncodeCache.hpp
+
+#ifndef ENCODE_CACHE_HPP
+#define ENCODE_CACHE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "Instruction.hpp"
+
+// 不引用符号的指令的编码缓存：规范化的指令文本（词法单元以 '\n' 连接）-> 解码结果和机器码。
+// clang -O0 的输出中同样的行（lw a0, -20(s0)、addi sp, sp, -32）反复出现，命中时跳过解析和编码。
+// 这类指令的编码与地址无关，引用符号（包括 %function）的指令和编码出错的指令不进入缓存。
+// 缓存项只追加不删除，下标在整个生命周期内有效；批量 / 常驻进程中可以用 shared() 跨文件共享
+class EncodeCache
+{
+public:
+  static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+  static constexpr size_t MAX_ENTRIES = 1 << 16; // 达到上限后不再加入新项
+
+  struct Entry
+  {
+    Instruction instruction;
+    uint32_t words[Instruction::MAX_ENCODED_WORDS];
+    uint32_t count;
+  };
+
+  // 查找一行指令，命中时返回缓存项下标，否则返回 NO_ENTRY（之后可用 insert 加入这一行）
+  uint32_t find(const TokenArena &arena, const LexedLine &line);
+
+  // 把上一次 find 未命中的那一行的解码结果加入缓存，不可缓存时返回 NO_ENTRY
+  uint32_t insert(const Instruction &instruction);
+
+  const Entry &operator[](uint32_t index) const { return entries[index]; }
+
+  size_t getHits() const { return hits; }
+  size_t getMisses() const { return misses; }
+  size_t size() const { return entries.size(); }
+
+  // 进程级的共享实例
+  static EncodeCache &shared();
+
+private:
+  void grow();
+
+  std::vector<Entry> entries;
+  std::vector<std::string> keys;   // 与 entries 一一对应
+  std::vector<uint64_t> hashes;    // 与 entries 一一对应
+  std::vector<uint32_t> slots;     // 开放寻址表，值为 entries 下标 + 1，0 为空槽
+  std::string key;                 // 上一次 find 的规范化文本（复用缓冲区）
+  uint64_t keyHash = 0;
+  size_t hits = 0;
+  size_t misses = 0;
+  FixupList noFixups;              // 可缓存的指令不引用符号，不会登记修补记录
+};
+
+#endif // ENCODE_CACHE_HPP
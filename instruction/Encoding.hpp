@@ -0,0 +1,94 @@
+// instruction/Encoding.hpp
+
+#ifndef ENCODING_HPP
+#define ENCODING_HPP
+
+#include "Opcode.hpp"
+#include <cstdint>
+
+// 按格式把各字段拼成 32 位指令字。格式是模板参数，位布局在编译期选定；
+// 操作码表是 constexpr，调用处的操作码为常量时 opcode/funct 也一并折叠成常数。
+// imm 的含义由格式决定：I/L/S 为 12 位立即数，B/J 为字节偏移，U 为高 20 位
+template <Format F>
+constexpr uint32_t packInstruction(const OpcodeInfo &info, uint32_t rd, uint32_t rs1, uint32_t rs2, int32_t imm)
+{
+  static_assert(F != Format::P, "伪指令没有固定的位布局，需展开为实际指令后再编码");
+
+  uint32_t bits = static_cast<uint32_t>(imm);
+  uint32_t word = info.opcode & 0x7F;
+  if constexpr (F == Format::R || F == Format::M)
+  {
+    word |= (rd & 0x1F) << 7;            // rd: bits 7-11
+    word |= (info.funct3 & 0x7) << 12;   // funct3: bits 12-14
+    word |= (rs1 & 0x1F) << 15;          // rs1: bits 15-19
+    word |= (rs2 & 0x1F) << 20;          // rs2: bits 20-24
+    word |= (info.funct7 & 0x7F) << 25;  // funct7: bits 25-31
+  }
+  else if constexpr (F == Format::I || F == Format::L)
+  {
+    word |= (rd & 0x1F) << 7;            // rd: bits 7-11
+    word |= (info.funct3 & 0x7) << 12;   // funct3: bits 12-14
+    word |= (rs1 & 0x1F) << 15;          // rs1: bits 15-19
+    word |= (bits & 0xFFF) << 20;        // imm[11:0]: bits 20-31
+  }
+  else if constexpr (F == Format::S)
+  {
+    word |= (bits & 0x1F) << 7;          // imm[4:0]: bits 7-11
+    word |= (info.funct3 & 0x7) << 12;   // funct3: bits 12-14
+    word |= (rs1 & 0x1F) << 15;          // rs1: bits 15-19
+    word |= (rs2 & 0x1F) << 20;          // rs2: bits 20-24
+    word |= ((bits >> 5) & 0x7F) << 25;  // imm[11:5]: bits 25-31
+  }
+  else if constexpr (F == Format::B)
+  {
+    // 沿用原有的位布局：以半字偏移拆分各段
+    uint32_t half = bits >> 1;
+    word |= ((half >> 4) & 0x1) << 7;    // bit 7
+    word |= (half & 0xF) << 8;           // bits 8-11
+    word |= (info.funct3 & 0x7) << 12;   // funct3: bits 12-14
+    word |= (rs1 & 0x1F) << 15;          // rs1: bits 15-19
+    word |= (rs2 & 0x1F) << 20;          // rs2: bits 20-24
+    word |= ((half >> 5) & 0x3F) << 25;  // bits 25-30
+    word |= ((half >> 11) & 0x1) << 31;  // bit 31
+  }
+  else if constexpr (F == Format::U)
+  {
+    word |= (rd & 0x1F) << 7;            // rd: bits 7-11
+    word |= (bits & 0xFFFFF) << 12;      // imm[31:12]: bits 12-31
+  }
+  else if constexpr (F == Format::J)
+  {
+    word |= (rd & 0x1F) << 7;            // rd: bits 7-11
+    word |= ((bits >> 12) & 0xFF) << 12; // imm[19:12]: bits 12-19
+    word |= ((bits >> 11) & 0x1) << 20;  // imm[11]: bit 20
+    word |= ((bits >> 1) & 0x3FF) << 21; // imm[10:1]: bits 21-30
+    word |= ((bits >> 20) & 0x1) << 31;  // imm[20]: bit 31
+  }
+  return word;
+}
+
+// 按操作码编号编码（操作码为常量时整条路径在编译期求值）
+template <Format F>
+constexpr uint32_t packInstruction(Opcode op, uint32_t rd, uint32_t rs1, uint32_t rs2, int32_t imm)
+{
+  return packInstruction<F>(OpcodeTable::info(op), rd, rs1, rs2, imm);
+}
+
+// 只打包立即数字段（opcode、寄存器均为 0），修补记录回填时与指令模板按位或
+template <Format F>
+constexpr uint32_t packImmediate(int32_t imm)
+{
+  return packInstruction<F>(OpcodeInfo{}, 0, 0, 0, imm);
+}
+
+// 编译期自检：与标准汇编器的输出对照
+static_assert(packInstruction<Format::R>(Opcode::Add, 10, 11, 12, 0) == 0x00C58533, "add a0, a1, a2");
+static_assert(packInstruction<Format::M>(Opcode::Mul, 10, 11, 12, 0) == 0x02C58533, "mul a0, a1, a2");
+static_assert(packInstruction<Format::I>(Opcode::Addi, 2, 2, 0, -16) == 0xFF010113, "addi sp, sp, -16");
+static_assert(packInstruction<Format::L>(Opcode::Lw, 10, 2, 0, 12) == 0x00C12503, "lw a0, 12(sp)");
+static_assert(packInstruction<Format::S>(Opcode::Sw, 0, 2, 1, 12) == 0x00112623, "sw ra, 12(sp)");
+static_assert(packInstruction<Format::U>(Opcode::Lui, 10, 0, 0, 0x12345) == 0x12345537, "lui a0, 0x12345");
+static_assert(packInstruction<Format::J>(Opcode::Jal, 1, 0, 0, 16) == 0x010000EF, "jal ra, 16");
+static_assert((packInstruction<Format::S>(Opcode::Sw, 0, 2, 1, 0) | packImmediate<Format::S>(12)) == 0x00112623, "模板 + 修补");
+
+#endif // ENCODING_HPP
@@ -0,0 +1,183 @@
+// instruction/Fixup.cpp
+
+#include "Fixup.hpp"
+#include "Encoding.hpp"
+#include "../utils/Trace.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+  // 立即数的算法（S 为符号地址加 addend，P 为被修补字的地址）
+  enum class FixupValue : uint8_t
+  {
+    Absolute,    // S
+    Lo12,        // S & 0xFFF
+    Hi20,        // (S + 0x800) >> 12
+    Upper,       // S >> 12
+    PcRel,       // S - P
+    PcrelHi20,   // (S - P + 0x800) >> 12
+    PcrelLo12,   // call 的 jalr：以前一个字（auipc）为 PC，减去 auipc 已经加上的高位
+    Invalid,     // 不允许的 %function，报 rangeError
+    Unsupported  // 不认识的 %function，报函数名
+  };
+
+  struct FixupInfo
+  {
+    FixupValue value;
+    Format format;             // 立即数的位布局
+    ImmKind range;             // 范围检查，None 为不检查
+    uint8_t alignment;         // 对齐要求，0 为不检查
+    RelocationType relocation; // 符号未定义时的重定位类型
+    const char *alignError;
+    const char *rangeError;
+    bool withValue;            // rangeError 之后是否附上立即数
+  };
+
+  constexpr const char *I_RANGE = "Immediate value out of range for I-type instruction: ";
+  constexpr const char *S_RANGE = "Immediate value out of range for S-type instruction: ";
+  constexpr const char *U_RANGE = "Immediate value out of range for U-type instruction: ";
+  constexpr const char *J_ALIGN = "Jump target address must be 4-byte aligned.";
+
+  // 与 FixupKind 一一对应，报错信息与原来各格式编码时的一致
+  constexpr FixupInfo FixupTable[] = {
+      {FixupValue::Absolute, Format::I, ImmKind::I12, 0, R_RISCV_32, nullptr, I_RANGE, true},
+      {FixupValue::Lo12, Format::I, ImmKind::I12, 0, R_RISCV_LO12_I, nullptr, I_RANGE, true},
+      {FixupValue::Lo12, Format::L, ImmKind::None, 0, R_RISCV_LO12_I, nullptr, nullptr, false},
+      {FixupValue::Lo12, Format::S, ImmKind::S12, 0, R_RISCV_LO12_S, nullptr, S_RANGE, true},
+      {FixupValue::PcRel, Format::B, ImmKind::B13, 2, R_RISCV_BRANCH, "Branch target address must be 2-byte aligned.", "Branch offset out of range.", false},
+      {FixupValue::Hi20, Format::U, ImmKind::U20, 0, R_RISCV_HI20, nullptr, U_RANGE, true},
+      {FixupValue::PcrelHi20, Format::U, ImmKind::U20, 0, R_RISCV_PCREL_HI20, nullptr, U_RANGE, true},
+      {FixupValue::Upper, Format::U, ImmKind::U20, 0, R_RISCV_HI20, nullptr, U_RANGE, true},
+      {FixupValue::PcRel, Format::J, ImmKind::J21, 4, R_RISCV_JAL, J_ALIGN, "Jump offset out of range for J-type instruction: ", true},
+      {FixupValue::PcRel, Format::J, ImmKind::J21, 4, R_RISCV_JAL, J_ALIGN, "Jump offset out of range for jal: ", true},
+      {FixupValue::Hi20, Format::U, ImmKind::None, 0, R_RISCV_HI20, nullptr, nullptr, false},
+      {FixupValue::Lo12, Format::I, ImmKind::None, 0, R_RISCV_LO12_I, nullptr, nullptr, false},
+      {FixupValue::PcrelHi20, Format::U, ImmKind::None, 0, R_RISCV_PCREL_HI20, nullptr, nullptr, false},
+      {FixupValue::PcrelLo12, Format::I, ImmKind::None, 0, R_RISCV_PCREL_LO12_I, nullptr, nullptr, false},
+      {FixupValue::Invalid, Format::I, ImmKind::None, 0, R_RISCV_LO12_I, nullptr, "I-type instructions cannot use %hi function.", false},
+      {FixupValue::Invalid, Format::L, ImmKind::None, 0, R_RISCV_LO12_I, nullptr, "Load instructions cannot use %hi function.", false},
+      {FixupValue::Invalid, Format::S, ImmKind::None, 0, R_RISCV_LO12_S, nullptr, "S-type instructions cannot use %hi function.", false},
+      {FixupValue::Unsupported, Format::I, ImmKind::None, 0, R_RISCV_LO12_I, nullptr, nullptr, false},
+      {FixupValue::Unsupported, Format::S, ImmKind::None, 0, R_RISCV_LO12_S, nullptr, nullptr, false},
+      {FixupValue::Unsupported, Format::U, ImmKind::None, 0, R_RISCV_PCREL_HI20, nullptr, nullptr, false},
+  };
+  static_assert(sizeof(FixupTable) / sizeof(FixupTable[0]) == static_cast<size_t>(FixupKind::Count), "FixupTable 必须与 FixupKind 一一对应");
+
+  uint32_t packImmediateBits(Format format, int32_t imm)
+  {
+    switch (format)
+    {
+    case Format::I:
+      return packImmediate<Format::I>(imm);
+    case Format::L:
+      return packImmediate<Format::L>(imm);
+    case Format::S:
+      return packImmediate<Format::S>(imm);
+    case Format::B:
+      return packImmediate<Format::B>(imm);
+    case Format::U:
+      return packImmediate<Format::U>(imm);
+    case Format::J:
+      return packImmediate<Format::J>(imm);
+    default:
+      return 0;
+    }
+  }
+}
+
+uint32_t FixupList::immediateBits(const Fixup &fixup, uint32_t symbolAddress)
+{
+  const FixupInfo &info = FixupTable[static_cast<size_t>(fixup.kind)];
+  uint32_t target = symbolAddress + static_cast<uint32_t>(fixup.addend);
+  int32_t offset = static_cast<int32_t>(target) - static_cast<int32_t>(fixup.address);
+  int32_t imm = 0;
+
+  switch (info.value)
+  {
+  case FixupValue::Absolute:
+    imm = static_cast<int32_t>(target);
+    break;
+  case FixupValue::Lo12:
+    imm = static_cast<int32_t>(target & 0xFFF);
+    break;
+  case FixupValue::Hi20:
+    imm = static_cast<int32_t>((target + 0x800) >> 12);
+    break;
+  case FixupValue::Upper:
+    imm = static_cast<int32_t>(target >> 12);
+    break;
+  case FixupValue::PcRel:
+    imm = offset;
+    break;
+  case FixupValue::PcrelHi20:
+    imm = (offset + 0x800) >> 12;
+    break;
+  case FixupValue::PcrelLo12:
+  {
+    offset += 4; // PC 为前一个字（auipc）的地址
+    uint32_t high = static_cast<uint32_t>((offset + 0x800) >> 12);
+    imm = static_cast<int32_t>(static_cast<uint32_t>(offset) - (high << 12));
+    break;
+  }
+  case FixupValue::Invalid:
+    throw std::runtime_error(info.rangeError);
+  case FixupValue::Unsupported:
+    throw std::runtime_error("Unsupported immediate function: " + std::string(StringPool::str(static_cast<Atom>(fixup.addend))));
+  }
+
+  if (info.alignment != 0 && imm % info.alignment != 0)
+  {
+    throw std::runtime_error(info.alignError);
+  }
+  if (info.range != ImmKind::None && !OpcodeTable::fitsImmediate(info.range, imm))
+  {
+    throw std::runtime_error(info.withValue ? info.rangeError + std::to_string(imm) : std::string(info.rangeError));
+  }
+  return packImmediateBits(info.format, imm);
+}
+
+void FixupList::addRelocation(const Fixup &fixup, SymbolTable &symbolTable, RelocationTable &relocationTable, uint32_t sectionIndex)
+{
+  if (fixup.kind == FixupKind::Branch)
+  {
+    // 原来的 B 型编码在符号不存在时查询符号所在的段，因而报错
+    throw std::runtime_error("Symbol not found: " + std::string(StringPool::str(fixup.symbol)));
+  }
+  const FixupInfo &info = FixupTable[static_cast<size_t>(fixup.kind)];
+  TRACE(Reloc, Debug, StringPool::str(relocationTable.getSectionName(sectionIndex)) << "+" << fixup.address << "：" << StringPool::str(fixup.symbol)
+                                                                                 << " 类型 " << static_cast<uint32_t>(info.relocation));
+  relocationTable.addRelocation(sectionIndex, fixup.address, symbolTable.reference(fixup.symbol), info.relocation);
+}
+
+bool FixupList::resolveOne(const Fixup &fixup, SymbolTable &symbolTable, RelocationTable &relocationTable, Atom section, uint32_t &bits)
+{
+  if (const Symbol *target = symbolTable.findSymbol(fixup.symbol))
+  {
+    bits = immediateBits(fixup, target->getGAddress());
+    return true;
+  }
+  addRelocation(fixup, symbolTable, relocationTable, relocationTable.sectionIndex(section));
+  return false;
+}
+
+void FixupList::sortBySymbol()
+{
+  order.resize(fixups.size());
+  for (uint32_t i = 0; i < order.size(); i++)
+  {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+            { return fixups[a].symbol != fixups[b].symbol ? fixups[a].symbol < fixups[b].symbol : a < b; });
+  unresolved.assign(fixups.size(), 0);
+}
+
+void FixupList::clear()
+{
+  fixups.clear();
+  order.clear();
+  unresolved.clear();
+  base = 0;
+}
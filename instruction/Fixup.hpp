@@ -0,0 +1,130 @@
+// instruction/Fixup.hpp
+
+#ifndef FIXUP_HPP
+#define FIXUP_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "../symbol_table/SymbolTable.hpp"
+#include "../relocation_table/RelocationTable.hpp"
+#include "../utils/StringPool.hpp"
+
+// 修补类型：决定如何由符号地址 S、被修补字的地址 P 算出立即数，放进哪种位布局，
+// 做哪些检查，以及符号未定义时生成哪种重定位项。各类型的参数见 Fixup.cpp 中的 FixupTable
+enum class FixupKind : uint8_t
+{
+  AbsI,           // I 型立即数为标签：S，检查 12 位范围（R_RISCV_32）
+  Lo12I,          // I 型 %lo：S & 0xFFF，检查 12 位范围（R_RISCV_LO12_I）
+  Lo12L,          // 取数指令的标签或 %lo：S & 0xFFF，不检查范围（R_RISCV_LO12_I）
+  Lo12S,          // S 型的标签或 %lo：S & 0xFFF，检查 12 位范围（R_RISCV_LO12_S）
+  Branch,         // B 型：S - P，2 字节对齐，13 位范围；符号不存在时报错
+  Hi20,           // U 型 %hi：(S + 0x800) >> 12（R_RISCV_HI20）
+  PcrelHi20,      // U 型 %pcrel_hi：(S - P + 0x800) >> 12（R_RISCV_PCREL_HI20）
+  AbsU,           // U 型立即数为标签：S >> 12（R_RISCV_HI20）
+  Jal,            // J 型：S - P，4 字节对齐，21 位范围（R_RISCV_JAL）
+  JalPseudo,      // j label 展开的 jal，与 Jal 只有报错信息不同
+  LiHi20,         // li rd, symbol 的 lui：(S + 0x800) >> 12，不检查（R_RISCV_HI20）
+  LiLo12,         // li rd, symbol 的 addi：S & 0xFFF，不检查（R_RISCV_LO12_I）
+  CallHi20,       // call 的 auipc：(S - P + 0x800) >> 12（R_RISCV_PCREL_HI20）
+  CallLo12,       // call 的 jalr：auipc 之后剩下的低位，PC 取前一个字（R_RISCV_PCREL_LO12_I）
+  HiInI,          // I 型用了 %hi：符号已定义时报错（R_RISCV_LO12_I）
+  HiInL,          // 取数指令用了 %hi：同上（R_RISCV_LO12_I）
+  HiInS,          // S 型用了 %hi：同上（R_RISCV_LO12_S）
+  UnknownLo12I,   // I/L 型不支持的 %function：符号已定义时报错（R_RISCV_LO12_I）
+  UnknownLo12S,   // S 型不支持的 %function：同上（R_RISCV_LO12_S）
+  UnknownHi20U,   // U 型不支持的 %function：同上（R_RISCV_PCREL_HI20）
+  Count
+};
+
+// 一条修补记录：编码时立即数字段留 0，由 FixupList::resolve 统一回填或转成重定位项
+struct Fixup
+{
+  uint32_t offset;  // 被修补的字在输出中的字节偏移
+  uint32_t address; // 被修补的字的地址（PC 相对计算和重定位位置）
+  Atom symbol;
+  int32_t addend;   // 加到 S 上的附加值；Unknown* 类型借用它保存 %function 的原名
+  FixupKind kind;
+};
+
+// 一段输出的修补记录
+class FixupList
+{
+public:
+  // 之后 add 的记录以 base 为起点：编码每条指令前设为该指令第一个字在输出中的字节偏移
+  void setBase(uint32_t offset) { base = offset; }
+
+  // 登记指令的第 word 个字（0 起）
+  void add(uint32_t word, uint32_t address, Atom symbol, FixupKind kind, int32_t addend = 0)
+  {
+    fixups.push_back({base + word * 4, address, symbol, addend, kind});
+  }
+
+  // 统一解析：按符号排序后每个符号只查一次符号表，已定义的算出立即数并调用 patch(offset, bits)
+  // 把位或进输出中的字；其余按原来的顺序生成重定位项（节名为 section，引用的符号登记为外部符号）。处理完后清空
+  template <typename Patch>
+  void resolve(SymbolTable &symbolTable, RelocationTable &relocationTable, Atom section, Patch &&patch)
+  {
+    sortBySymbol();
+    for (size_t begin = 0; begin < order.size();)
+    {
+      Atom symbol = fixups[order[begin]].symbol;
+      const Symbol *target = symbolTable.findSymbol(symbol);
+      size_t end = begin;
+      for (; end < order.size() && fixups[order[end]].symbol == symbol; end++)
+      {
+        if (target)
+        {
+          const Fixup &fixup = fixups[order[end]];
+          patch(fixup.offset, immediateBits(fixup, target->getGAddress()));
+        }
+      }
+      if (!target)
+      {
+        for (size_t i = begin; i < end; i++)
+        {
+          unresolved[order[i]] = 1;
+        }
+      }
+      begin = end;
+    }
+    uint32_t sectionIndex = RelocationTable::NO_SECTION;
+    for (size_t i = 0; i < fixups.size(); i++)
+    {
+      if (unresolved[i])
+      {
+        if (sectionIndex == RelocationTable::NO_SECTION)
+        {
+          sectionIndex = relocationTable.sectionIndex(section);
+        }
+        addRelocation(fixups[i], symbolTable, relocationTable, sectionIndex);
+      }
+    }
+    clear();
+  }
+
+  // 解析一条记录：符号已定义时返回 true 并给出要或进字里的位（流式模式逐条回填时使用）
+  static bool resolveOne(const Fixup &fixup, SymbolTable &symbolTable, RelocationTable &relocationTable, Atom section, uint32_t &bits);
+
+  // 由符号地址算出立即数并按该类型的位布局打包，检查失败时抛出异常（地址不经符号表时直接使用，如数字局部标签）
+  static uint32_t immediateBits(const Fixup &fixup, uint32_t symbolAddress);
+
+  const std::vector<Fixup> &items() const { return fixups; }
+  size_t size() const { return fixups.size(); }
+  bool empty() const { return fixups.empty(); }
+  void clear();
+
+private:
+
+  // 符号未定义：生成重定位项（B 型按原来的行为报错）
+  static void addRelocation(const Fixup &fixup, SymbolTable &symbolTable, RelocationTable &relocationTable, uint32_t sectionIndex);
+
+  void sortBySymbol();
+
+  std::vector<Fixup> fixups;
+  std::vector<uint32_t> order;     // 按 (symbol, 下标) 排序后的下标
+  std::vector<uint8_t> unresolved; // 与 fixups 一一对应
+  uint32_t base = 0;
+};
+
+#endif // FIXUP_HPP
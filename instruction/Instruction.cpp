@@ -15,152 +15,217 @@
 
 #include "../utils/Utils.hpp"
 #include <stdexcept>
-#include <sstream>
+#include <cctype>
 
-void Instruction::parseLine(const std::string &line)
+namespace
 {
-  std::string trimmedLine = Utils::trim(line);
-
-  // 找到操作码
-  size_t pos = trimmedLine.find('\t');
-  if (pos == std::string::npos)
-  {
-    opcode = trimmedLine;
-    return;
-  }
-
-  opcode = trimmedLine.substr(0, pos);
-  std::string operandStr = trimmedLine.substr(pos + 1);
-  operandStr = Utils::trim(operandStr);
-
-  // 自定义解析操作数
-  size_t index = 0;
-  while (index < operandStr.size())
+  // 以括号外的逗号分隔操作数，操作数文本取首尾词法单元之间的源文本
+  void splitOperands(const TokenArena &arena, const LexedLine &line, const Token *token, Operands &operands)
   {
-    // 跳过分隔符和空白字符
-    while (index < operandStr.size() && (operandStr[index] == ',' || isspace(operandStr[index])))
-    {
-      index++;
-    }
-    if (index >= operandStr.size())
+    const Token *end = arena.end(line);
+    while (token != end)
     {
-      break;
-    }
-
-    std::string operand;
-    if (operandStr[index] == '(')
-    {
-      // 处理括号内的内容
-      size_t endIndex = operandStr.find(')', index);
-      if (endIndex == std::string::npos)
+      const Token *first = token;
+      int depth = 0;
+      while (token != end && !(token->kind == TokenKind::Comma && depth == 0))
       {
-        throw std::runtime_error("Unmatched parenthesis in operand: " + operandStr);
+        if (token->kind == TokenKind::LParen)
+        {
+          depth++;
+        }
+        else if (token->kind == TokenKind::RParen)
+        {
+          depth--;
+        }
+        ++token;
       }
-      operand = operandStr.substr(index, endIndex - index + 1);
-      index = endIndex + 1;
-    }
-    else if (operandStr[index] == '%')
-    {
-      // 处理特殊表达式，例如 %hi(sa)
-      size_t endIndex = index;
-      while (endIndex < operandStr.size() && operandStr[endIndex] != ',' && !isspace(operandStr[endIndex]))
+      if (depth != 0)
       {
-        endIndex++;
+        throw std::runtime_error("Unmatched parenthesis in operand: " + std::string(arena.text(line)));
       }
-      operand = operandStr.substr(index, endIndex - index);
-      index = endIndex;
-    }
-    else
-    {
-      // 处理一般操作数
-      size_t endIndex = index;
-      while (endIndex < operandStr.size() && operandStr[endIndex] != ',' && !isspace(operandStr[endIndex]))
+      if (token != first)
       {
-        endIndex++;
+        const Token &last = *(token - 1);
+        if (operands.count < Operands::MAX_OPERANDS)
+        {
+          operands.items[operands.count] = std::string_view(arena.getBase() + first->offset, last.offset + last.length - first->offset);
+        }
+        operands.count++;
+      }
+      if (token != end)
+      {
+        ++token; // 跳过逗号
       }
-      operand = operandStr.substr(index, endIndex - index);
-      index = endIndex;
     }
-
-    operands.push_back(Utils::trim(operand));
   }
 }
 
-// 指令工厂方法，根据操作码创建对应的指令对象
-std::unique_ptr<Instruction> Instruction::create(const std::string &line)
+// 查表得到操作码编号，再按格式解析操作数；整条指令只解析这一次
+Instruction Instruction::decode(const TokenArena &arena, const LexedLine &line)
 {
-  // 临时创建一个指令对象以解析操作码
-  class TempInstruction : public Instruction
+  const Token *first = arena.begin(line);
+  if (first == arena.end(line))
   {
-  public:
-    TempInstruction(const std::string &line)
-    {
-      parseLine(line);
-    }
-    std::vector<uint32_t> encode(const SymbolTable &, RelocationTable &, std::unordered_map<std::string, Section> &, uint32_t, std::string) override
-    {
-      // 不需要实现
-    }
-  };
+    throw std::runtime_error("Empty instruction line");
+  }
+  std::string_view opcode = arena.text(*first);
 
-  TempInstruction temp(line);
-  const std::string &opcode = temp.opcode;
+  Instruction instruction;
+  if (!OpcodeTable::lookup(opcode, instruction.op))
+  {
+    throw std::runtime_error("Unsupported instruction: " + std::string(opcode));
+  }
+  Operands operands;
+  splitOperands(arena, line, first + 1, operands);
 
-  // 根据操作码创建对应的指令对象
-  if (opcode == "addi" || opcode == "ori" || opcode == "andi" ||
-      opcode == "xori" || opcode == "slli" || opcode == "srli" || opcode == "jalr")
+  switch (OpcodeTable::info(instruction.op).format)
   {
-    return std::make_unique<InstructionI>(line);
+  case Format::I:
+    InstructionI::decode(operands, instruction);
+    break;
+  case Format::L:
+    InstructionL::decode(operands, instruction);
+    break;
+  case Format::R:
+    InstructionR::decode(operands, instruction);
+    break;
+  case Format::S:
+    InstructionS::decode(operands, instruction);
+    break;
+  case Format::B:
+    InstructionB::decode(operands, instruction);
+    break;
+  case Format::U:
+    InstructionU::decode(operands, instruction);
+    break;
+  case Format::J:
+    InstructionJ::decode(operands, instruction);
+    break;
+  case Format::P:
+    InstructionP::decode(operands, instruction);
+    break;
+  case Format::M:
+    InstructionM::decode(operands, instruction);
+    break;
   }
-  else if (opcode == "lb" || opcode == "lh" || opcode == "lw" || opcode == "ld")
+  return instruction;
+}
+
+size_t Instruction::encode(uint32_t currentAddress, uint32_t *out, FixupList &fixups) const
+{
+  switch (OpcodeTable::info(op).format)
   {
-    return std::make_unique<InstructionL>(line);
+  case Format::I:
+    return InstructionI::encode(*this, currentAddress, out, fixups);
+  case Format::L:
+    return InstructionL::encode(*this, currentAddress, out, fixups);
+  case Format::R:
+    return InstructionR::encode(*this, currentAddress, out, fixups);
+  case Format::S:
+    return InstructionS::encode(*this, currentAddress, out, fixups);
+  case Format::B:
+    return InstructionB::encode(*this, currentAddress, out, fixups);
+  case Format::U:
+    return InstructionU::encode(*this, currentAddress, out, fixups);
+  case Format::J:
+    return InstructionJ::encode(*this, currentAddress, out, fixups);
+  case Format::P:
+    return InstructionP::encode(*this, currentAddress, out, fixups);
+  case Format::M:
+    return InstructionM::encode(*this, currentAddress, out, fixups);
   }
-  // R 型指令
-  else if (opcode == "add" || opcode == "sub" || opcode == "and" ||
-           opcode == "or" || opcode == "xor" || opcode == "sll" ||
-           opcode == "srl")
+  throw std::runtime_error("Unsupported instruction: " + mnemonic());
+}
+
+size_t Instruction::getEncodedLength() const
+{
+  if (OpcodeTable::info(op).format == Format::P)
   {
-    return std::make_unique<InstructionR>(line);
+    return InstructionP::getEncodedLength(*this);
   }
-  // S 型指令
-  else if (opcode == "sb" || opcode == "sh" || opcode == "sw" || opcode == "sd")
+  return 1;
+}
+
+std::string Instruction::mnemonic() const
+{
+  return std::string(OpcodeTable::info(op).mnemonic);
+}
+
+void Instruction::setImmediate(std::string_view text)
+{
+  if (!text.empty() && text[0] == '%')
   {
-    return std::make_unique<InstructionS>(line);
+    // %function(symbol)：符号部分保留括号，与函数名一起在编码时解析
+    size_t funcEnd = text.find('(');
+    if (funcEnd == std::string_view::npos)
+    {
+      funcEnd = text.length();
+    }
+    setFunction(text.substr(1, funcEnd - 1));
+    symbol = StringPool::intern(text.substr(funcEnd));
+    imm = 0; // 立即数将在链接时解析
   }
-  // B 型指令
-  else if (opcode == "beq" || opcode == "bne" || opcode == "blt" ||
-           opcode == "bge" || opcode == "bltu" || opcode == "bgeu")
+  else
   {
-    return std::make_unique<InstructionB>(line);
+    // 先按数字解析，不是数字时是标签（1b、1f 这样的数字局部标签引用也是）
+    ParseStatus status = Utils::parseImmediate(text, imm);
+    uint32_t number;
+    bool forward;
+    if (status == ParseStatus::NotNumber || (status == ParseStatus::Invalid && Utils::parseLocalLabelReference(text, number, forward)))
+    {
+      symbol = StringPool::intern(text);
+      imm = 0;
+    }
+    else if (status != ParseStatus::Ok)
+    {
+      throw Utils::immediateError(status, text);
+    }
   }
-  // U 型指令
-  else if (opcode == "lui" || opcode == "auipc")
+}
+
+void Instruction::setFunction(std::string_view name)
+{
+  functionName = StringPool::intern(name);
+  if (name.empty())
   {
-    return std::make_unique<InstructionU>(line);
+    function = ImmFunction::None;
   }
-  // J 型指令
-  else if (opcode == "jal")
+  else if (name == "lo")
   {
-    return std::make_unique<InstructionJ>(line);
+    function = ImmFunction::Lo;
   }
-  // P 型伪指令
-  else if (opcode == "mv" || opcode == "li" || opcode == "j" ||
-           opcode == "nop" || opcode == "call" || opcode == "ret")
+  else if (name == "hi")
   {
-    return std::make_unique<InstructionP>(line);
+    function = ImmFunction::Hi;
   }
-  // M 型指令
-  else if (opcode == "mul" || opcode == "mulh" || opcode == "mulhsu" ||
-           opcode == "mulhu" || opcode == "div" || opcode == "rem" || opcode == "remu")
+  else if (name == "pcrel_hi")
   {
-    return std::make_unique<InstructionM>(line);
+    function = ImmFunction::PcrelHi;
   }
   else
   {
-    throw std::runtime_error("Unsupported instruction: " + opcode);
+    function = ImmFunction::Other;
+  }
+}
+
+void Instruction::addLo12Fixup(FixupList &fixups, uint32_t currentAddress, FixupKind lo, FixupKind hi, FixupKind unknown) const
+{
+  if (function == ImmFunction::Lo)
+  {
+    fixups.add(0, currentAddress, symbol, lo);
+  }
+  else if (function == ImmFunction::Hi)
+  {
+    fixups.add(0, currentAddress, symbol, hi);
   }
+  else
   {
-    throw std::runtime_error("Unsupported instruction: " + opcode);
+    // 报错时需要函数的原名，借用 addend 保存
+    fixups.add(0, currentAddress, symbol, unknown, static_cast<int32_t>(functionName));
   }
 }
+
+uint8_t Instruction::registerNumber(std::string_view name)
+{
+  return static_cast<uint8_t>(Utils::getRegisterNumber(name));
+}
@@ -4,33 +4,79 @@
 #define INSTRUCTION_HPP
 
 #include <string>
-#include <memory>
+#include <string_view>
 #include <vector>
+#include <cstdint>
 #include "../symbol_table/SymbolTable.hpp"
 #include "../relocation_table/RelocationTable.hpp"
-#include "../section/Section.hpp"
+#include "Fixup.hpp"
+#include "../lexer/Lexer.hpp"
+#include "../utils/StringPool.hpp"
+#include "Opcode.hpp"
 
-class Instruction
+// 立即数中 %function(symbol) 的函数名
+enum class ImmFunction : uint8_t
 {
-public:
-  // 析构函数
-  virtual ~Instruction() = default;
+  None,    // 没有 %function
+  Lo,      // %lo
+  Hi,      // %hi
+  PcrelHi, // %pcrel_hi
+  Other    // 其它（编码时按原名报错）
+};
+
+// 一条指令的操作数：以括号外的逗号分隔，指向源文本，不复制
+struct Operands
+{
+  static constexpr size_t MAX_OPERANDS = 4;
+
+  std::string_view items[MAX_OPERANDS];
+  size_t count = 0; // 实际个数（可能超过 MAX_OPERANDS，多出的部分不保存）
+
+  const std::string_view &operator[](size_t index) const { return items[index]; }
+};
+
+// 解码后的指令。按值保存：第一遍解析一次，之后编码不再访问源文本，
+// 没有虚函数调用，也没有逐条指令的堆分配。各格式的解析和编码见 InstructionX
+struct Instruction
+{
+  Opcode op = Opcode::Count;
+  uint8_t rd = 0;
+  uint8_t rs1 = 0;
+  uint8_t rs2 = 0;
+  ImmFunction function = ImmFunction::None;
+  Atom functionName = 0; // %function 的原名，为 0 表示没有
+  Atom symbol = 0;       // 引用的符号（标签或立即数中的符号），为 0 表示没有
+  int32_t imm = 0;
+
+  // 一条指令编码后最多的机器字数（li / call 展开为两条）
+  static constexpr size_t MAX_ENCODED_WORDS = 2;
+
+  // 由词法单元解码一条指令
+  static Instruction decode(const TokenArena &arena, const LexedLine &line);
+
+  // 编码，把机器码写入调用方提供的 out（至少 MAX_ENCODED_WORDS 个字），返回写入的字数。
+  // 不访问符号表：引用符号的立即数字段留 0，登记到 fixups，之后由 FixupList::resolve 统一回填。
+  // currentAddress 为第一个字的地址，登记前由调用方用 fixups.setBase 设好输出位置
+  size_t encode(uint32_t currentAddress, uint32_t *out, FixupList &fixups) const;
+
+  // 编码后的机器码字数
+  size_t getEncodedLength() const;
+
+  // 助记符，用于报错
+  std::string mnemonic() const;
 
-  // 编码函数，返回32位机器码
-  virtual std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) = 0;
+  // 把立即数文本归类为数值、符号或 %function(symbol)（I/S/J 型共用）
+  void setImmediate(std::string_view text);
 
-  // 创建指令对象的工厂方法
-  static std::unique_ptr<Instruction> create(const std::string &line);
+  // 记录 %function 的函数名
+  void setFunction(std::string_view name);
 
-public:
-  // 解析指令行，提取操作码和操作数
-  void parseLine(const std::string &line);
+  // 登记 I/L/S 型 %function(symbol) 的修补记录：%lo 为 lo，%hi 为 hi，其它函数为 unknown
+  // （后两种在符号已定义时报错，未定义时生成与 %lo 相同的重定位项）
+  void addLo12Fixup(FixupList &fixups, uint32_t currentAddress, FixupKind lo, FixupKind hi, FixupKind unknown) const;
 
-  std::string opcode;                // 操作码
-  std::vector<std::string> operands; // 操作数列表
-  std::string label;                 // 标签
-  std::string immFunction;           // 立即数函数名
-  std::string immSymbol;             // 立即数符号名
+  // 寄存器名 -> 编号
+  static uint8_t registerNumber(std::string_view name);
 };
 
 #endif // INSTRUCTION_HPP
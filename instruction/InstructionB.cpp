@@ -1,105 +1,38 @@
 // instruction/InstructionB.cpp
 
 #include "InstructionB.hpp"
+#include "Encoding.hpp"
 #include "../utils/Utils.hpp"
 #include "../relocation_table/RelocationTable.hpp"
 #include <stdexcept>
 
-const std::unordered_map<std::string, uint32_t> InstructionB::funct3Map = {
-    {"beq", 0x0},
-    {"bne", 0x1},
-    {"blt", 0x4},
-    {"bge", 0x5},
-    {"bltu", 0x6},
-    {"bgeu", 0x7}
-    // 可以添加更多 B 型指令的 funct3 映射
-};
-
-InstructionB::InstructionB(const std::string &line)
+// 解析操作数，提取 rs1, rs2, label
+void InstructionB::decode(const Operands &operands, Instruction &instruction)
 {
-  parseLine(line); // 解析指令行，提取 opcode 和 operands
-  parseOperands(); // 解析操作数，提取 rs1, rs2, label
-}
-
-void InstructionB::parseOperands()
-{
-  if (operands.size() != 3)
+  if (operands.count != 3)
   {
-    throw std::runtime_error("Invalid B-type instruction: " + opcode);
+    throw std::runtime_error("Invalid B-type instruction: " + instruction.mnemonic());
   }
 
   // 解析 rs1
-  rs1 = Utils::getRegisterNumber(operands[0]);
+  instruction.rs1 = Instruction::registerNumber(operands[0]);
 
   // 解析 rs2
-  rs2 = Utils::getRegisterNumber(operands[1]);
+  instruction.rs2 = Instruction::registerNumber(operands[1]);
 
   // 解析 label
-  label = operands[2];
+  instruction.symbol = StringPool::intern(operands[2]);
 }
-std::vector<uint32_t> InstructionB::encode(
-    const SymbolTable &symbolTable,
-    RelocationTable &relocationTable,
-    std::unordered_map<std::string, Section> &sectionTable,
-    uint32_t currentAddress,
-    std::string currentSecName)
-{
-  uint32_t opcodeVal = 0x63; // B 型指令的 opcode 固定为 0x63
-
-  // 获取 funct3
-  auto funct3It = funct3Map.find(opcode);
-  if (funct3It == funct3Map.end())
-  {
-    throw std::runtime_error("Unsupported B-type opcode: " + opcode);
-  }
-  uint32_t funct3 = funct3It->second;
-
-  int32_t imm_shifted = 0;
 
-  if (symbolTable.hasSymbol(label))
-  {
-    // 标签存在，计算偏移量
-    uint32_t labelAddress = symbolTable.getSymbol(label).getGAddress();
-    int32_t imm = static_cast<int32_t>(labelAddress) - static_cast<int32_t>(currentAddress);
-
-    if (imm % 2 != 0)
-    {
-      throw std::runtime_error("Branch target address must be 2-byte aligned.");
-    }
-
-    imm_shifted = imm >> 1;
+size_t InstructionB::encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups)
+{
+  const OpcodeInfo &info = OpcodeTable::info(instruction.op);
 
-    if (imm_shifted < -4096 || imm_shifted > 4095)
-    {
-      throw std::runtime_error("Branch offset out of range.");
-    }
-  }
-  else
-  {
-    // 标签不存在，添加重定位条目，立即数设为 0
-    imm_shifted = 0;
-    auto segName = symbolTable.getSymbol(label).getSegmentName();
-    relocationTable.addRelocation(segName, currentAddress, label, RelocationType::R_RISCV_BRANCH);
-  }
+  // 分支目标总是标签：偏移量、对齐和范围在回填时计算和检查
+  fixups.add(0, currentAddress, instruction.symbol, FixupKind::Branch);
 
-  // 将立即数分割为各个部分
-  uint32_t imm12 = (imm_shifted >> 11) & 0x1;   // imm[12]
-  uint32_t imm10_5 = (imm_shifted >> 5) & 0x3F; // imm[10:5]
-  uint32_t imm4_1 = imm_shifted & 0xF;          // imm[4:1]
-  uint32_t imm11 = (imm_shifted >> 4) & 0x1;    // imm[11]
-
-  // 组装指令
-  uint32_t instruction = 0;
-  instruction |= (imm12 << 31);
-  instruction |= (imm10_5 << 25);
-  instruction |= ((rs2 & 0x1F) << 20);
-  instruction |= ((rs1 & 0x1F) << 15);
-  instruction |= (funct3 << 12);
-  instruction |= (imm4_1 << 8);
-  instruction |= (imm11 << 7);
-  instruction |= opcodeVal;
-
-  return {instruction};
+  out[0] = packInstruction<Format::B>(info, 0, instruction.rs1, instruction.rs2, 0);
+  return 1;
 }
 // std::vector<uint32_t> InstructionB::encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName)
 // {
@@ -4,28 +4,17 @@
 #define INSTRUCTIONB_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionB : public Instruction
+// B 型指令（beq/bne/blt/bge/bltu/bgeu）的解析与编码
+class InstructionB
 {
 public:
-  // 构造函数，接受指令行字符串
-  InstructionB(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  // 实现基类的 encode 方法，返回32位机器码
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-private:
-  // 解析操作数的方法
-  void parseOperands();
-
-  uint32_t rs1; // 源寄存器1
-  uint32_t rs2; // 源寄存器2
-  int32_t imm;  // 分支偏移量（相对于当前地址）
-
-  // B 型指令的 funct3 映射表
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONB_HPP
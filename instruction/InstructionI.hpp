@@ -2,26 +2,17 @@
 #define INSTRUCTIONI_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionI : public Instruction
+// I 型指令（addi/ori/andi/xori/slli/srli/jalr）的解析与编码
+class InstructionI
 {
 public:
-  InstructionI(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-private:
-  void parseOperands();
-
-  uint32_t rd;
-  uint32_t rs1;
-  int32_t imm;
-
-  // 指令操作码、功能码映射表
-  static const std::unordered_map<std::string, uint32_t> opcodeMap;
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONI_HPP
@@ -4,24 +4,17 @@
 #define INSTRUCTIONJ_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionJ : public Instruction
+// J 型指令（jal）的解析与编码
+class InstructionJ
 {
 public:
-  InstructionJ(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-private:
-  void parseOperands();
-
-  uint32_t rd; // 目标寄存器
-  int32_t imm; // 跳转的立即数（偏移量）
-
-  // 操作码映射表，用于存储 J 型指令的 opcode
-  static const std::unordered_map<std::string, uint32_t> opcodeMap;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONJ_HPP
@@ -1,86 +1,59 @@
 // instruction/InstructionL.cpp
 
 #include "InstructionL.hpp"
+#include "Encoding.hpp"
 #include "../utils/Utils.hpp"
 #include <stdexcept>
 
-const std::unordered_map<std::string, uint32_t> InstructionL::opcodeMap = {
-    {"lb", 0x03},
-    {"lh", 0x03},
-    {"lw", 0x03},
-    {"lbu", 0x03},
-    {"lhu", 0x03},
-    // 添加更多的 Load 指令
-};
-
-const std::unordered_map<std::string, uint32_t> InstructionL::funct3Map = {
-    {"lb", 0x0},
-    {"lh", 0x1},
-    {"lw", 0x2},
-    {"lbu", 0x4},
-    {"lhu", 0x5},
-    // 添加更多的 Load 指令的 funct3
-};
-
-InstructionL::InstructionL(const std::string &line)
-{
-  parseLine(line);
-  parseOperands();
-}
-
-void InstructionL::parseOperands()
+void InstructionL::decode(const Operands &operands, Instruction &instruction)
 {
-  if (operands.size() != 2)
+  if (operands.count != 2)
   {
-    throw std::runtime_error("Invalid Load instruction operands: " + opcode);
+    throw std::runtime_error("Invalid Load instruction operands: " + instruction.mnemonic());
   }
 
-  rd = Utils::getRegisterNumber(operands[0]);
+  instruction.rd = Instruction::registerNumber(operands[0]);
 
   // 解析 offset(rs1)、%function(symbol)(rs1)、%function(symbol) 或 symbol 格式
-  std::string addr = operands[1];
+  std::string_view addr = operands[1];
   size_t posClose = addr.find(')');
   size_t posOpen = addr.find('(');
-  std::string offsetPart = (posClose != std::string::npos) ? addr.substr(0, posClose + 1) : addr;
-  std::string regPart = (posOpen != std::string::npos && posClose != std::string::npos) ? addr.substr(posClose + 1) : "";
+  std::string_view offsetPart = (posClose != std::string_view::npos) ? addr.substr(0, posClose + 1) : addr;
+  std::string_view regPart = (posOpen != std::string_view::npos && posClose != std::string_view::npos) ? addr.substr(posClose + 1) : std::string_view();
 
   // 去除空白字符
-  offsetPart = Utils::trim(offsetPart);
-  regPart = Utils::trim(regPart);
+  offsetPart = Utils::trimView(offsetPart);
+  regPart = Utils::trimView(regPart);
 
-  if (posOpen == std::string::npos)
+  if (posOpen == std::string_view::npos)
   {
-    immSymbol = offsetPart;
-    immFunction.clear();
-    imm = 0; // 等待符号地址解析
-    rs1 = 0; // 无基址寄存器
+    instruction.symbol = StringPool::intern(offsetPart); // 等待符号地址解析，无基址寄存器
   }
   else if (regPart.empty())
   {
-    // **分支 1: 标准形式 offset(rs1)**
+    // **分支 1: 标准形式 offset(rs1)**，省略 offset 时为 0
     // 示例指令: `lw a1, 100(a2)`
-    if (!offsetPart.empty() && (isdigit(offsetPart[0]) || offsetPart[0] == '-'))
+    size_t pos1 = offsetPart.find('(');
+    ParseStatus status = pos1 == 0 ? ParseStatus::Ok : Utils::parseImmediate(offsetPart.substr(0, pos1), instruction.imm);
+    if (status == ParseStatus::Ok)
     {
-      auto pos1 = offsetPart.find('(');
-      auto pos2 = offsetPart.find(')');
-      imm = Utils::stringToImmediate(offsetPart.substr(0, pos1));
-      rs1 = Utils::getRegisterNumber(offsetPart.substr(pos1 + 1, pos2 - pos1 - 1));
-      immFunction.clear();
-      immSymbol.clear();
+      size_t pos2 = offsetPart.find(')');
+      instruction.rs1 = Instruction::registerNumber(offsetPart.substr(pos1 + 1, pos2 - pos1 - 1));
+    }
+    else if (status != ParseStatus::NotNumber)
+    {
+      throw Utils::immediateError(status, offsetPart.substr(0, pos1));
     }
     // **分支 3: %function(symbol)**
     // 示例指令: `lw a1, %lo(sa)`
-    else if (!offsetPart.empty() && offsetPart[0] == '%')
+    else if (offsetPart[0] == '%')
     {
-      size_t pos1 = offsetPart.find('(');
-      if (pos1 == std::string::npos)
+      if (pos1 == std::string_view::npos)
       {
-        throw std::runtime_error("Invalid \%function(symbol) format in Load instruction: " + offsetPart);
+        throw std::runtime_error("Invalid \%function(symbol) format in Load instruction: " + std::string(offsetPart));
       }
-      immFunction = offsetPart.substr(1, pos1 - 1);                          // 提取 function 名
-      immSymbol = offsetPart.substr(pos1 + 1, offsetPart.size() - pos1 - 2); // 提取 symbol 名
-      imm = 0;                                                               // 立即数将在链接时解析
-      rs1 = 0;                                                               // 无基址寄存器
+      instruction.setFunction(offsetPart.substr(1, pos1 - 1));                                      // 提取 function 名
+      instruction.symbol = StringPool::intern(offsetPart.substr(pos1 + 1, offsetPart.size() - pos1 - 2)); // 提取 symbol 名
     }
   }
   else if (!offsetPart.empty() && !regPart.empty() && offsetPart[0] == '%')
@@ -89,117 +62,35 @@ void InstructionL::parseOperands()
     size_t pos2 = offsetPart.find(')');
     size_t pos3 = regPart.find('(');
     size_t pos4 = regPart.find(')');
-    immFunction = offsetPart.substr(1, pos1 - 1);             // 提取 function 名
-    immSymbol = offsetPart.substr(pos1 + 1, pos2 - pos1 - 1); // 提取 symbol 名
-    imm = 0;
-    rs1 = Utils::getRegisterNumber(regPart.substr(pos3 + 1, pos4 - pos3 - 1));
+    instruction.setFunction(offsetPart.substr(1, pos1 - 1));                         // 提取 function 名
+    instruction.symbol = StringPool::intern(offsetPart.substr(pos1 + 1, pos2 - pos1 - 1)); // 提取 symbol 名
+    instruction.rs1 = Instruction::registerNumber(regPart.substr(pos3 + 1, pos4 - pos3 - 1));
   }
   else
   {
-    throw std::runtime_error("Invalid Load instruction format: " + operands[1]);
+    throw std::runtime_error("Invalid Load instruction format: " + std::string(operands[1]));
   }
 }
 
-std::vector<uint32_t> InstructionL::encode(
-    const SymbolTable &symbolTable,
-    RelocationTable &relocationTable,
-    std::unordered_map<std::string, Section> &sectionTable,
-    uint32_t currentAddress,
-    std::string currentSecName)
+size_t InstructionL::encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups)
 {
-  auto opcodeIt = opcodeMap.find(opcode);
-  if (opcodeIt == opcodeMap.end())
-  {
-    throw std::runtime_error("Unsupported Load opcode: " + opcode);
-  }
-  uint32_t opcodeVal = opcodeIt->second;
+  const OpcodeInfo &info = OpcodeTable::info(instruction.op);
+  int32_t imm = instruction.imm;
 
-  auto funct3It = funct3Map.find(opcode);
-  if (funct3It == funct3Map.end())
-  {
-    throw std::runtime_error("Unsupported Load funct3 for opcode: " + opcode);
-  }
-  uint32_t funct3 = funct3It->second;
-
-  uint32_t instruction = 0;
-
-  if (!immFunction.empty())
+  if (instruction.function != ImmFunction::None)
   {
     // **情况1: %function(symbol)(rs1) 或 %function(symbol)**
-    if (symbolTable.hasSymbol(immSymbol))
-    {
-      const Symbol &symbol = symbolTable.getSymbol(immSymbol);
-      uint32_t symbolAddress = symbol.getGAddress();
-
-      if (immFunction == "lo")
-      {
-        imm = symbolAddress & 0xFFF;
-      }
-      else if (immFunction == "hi")
-      {
-        throw std::runtime_error("Load instructions cannot use %hi function.");
-      }
-      else
-      {
-        throw std::runtime_error("Unsupported immediate function: " + immFunction);
-      }
-    }
-    else
-    {
-      // 符号不存在，添加重定位条目
-      imm = 0;
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          immSymbol,
-          RelocationType::R_RISCV_LO12_I);
-    }
-
-    // 如果有基址寄存器（%function(symbol)(rs1)）
-    if (rs1 != 0)
-    {
-      instruction |= ((imm & 0xFFF) << 20); // imm[11:0]
-      instruction |= ((rs1 & 0x1F) << 15);  // rs1
-    }
-    else
-    {
-      // 没有基址寄存器（%function(symbol)）
-      instruction |= (imm & 0xFFF) << 20; // imm[11:0]
-      instruction |= (0 << 15);           // rs1 = x0
-    }
-  }
-  else if (!immSymbol.empty())
-  {
-    // **情况2: symbol 或 symbol(rs1)**
-    if (symbolTable.hasSymbol(immSymbol))
-    {
-      const Symbol &symbol = symbolTable.getSymbol(immSymbol);
-      imm = symbol.getGAddress() & 0xFFF;
-    }
-    else
-    {
-      // 符号不存在，添加重定位条目
-      imm = 0;
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          immSymbol,
-          RelocationType::R_RISCV_LO12_I);
-    }
-
-    instruction |= ((imm & 0xFFF) << 20); // imm[11:0]
-    instruction |= ((rs1 & 0x1F) << 15);  // rs1
+    instruction.addLo12Fixup(fixups, currentAddress, FixupKind::Lo12L, FixupKind::HiInL, FixupKind::UnknownLo12I);
+    imm = 0;
   }
-  else
+  else if (instruction.symbol != 0)
   {
-    // **情况3: offset(rs1)**
-    instruction |= ((imm & 0xFFF) << 20); // imm[11:0]
-    instruction |= ((rs1 & 0x1F) << 15);  // rs1
+    // **情况2: symbol 或 symbol(rs1)**，取符号地址的低 12 位
+    fixups.add(0, currentAddress, instruction.symbol, FixupKind::Lo12L);
+    imm = 0;
   }
+  // **情况3: offset(rs1)**，立即数已解析；没有基址寄存器时 rs1 为 x0
 
-  instruction |= ((funct3 & 0x7) << 12); // funct3
-  instruction |= ((rd & 0x1F) << 7);     // rd
-  instruction |= (opcodeVal & 0x7F);     // opcode
-
-  return {instruction};
+  out[0] = packInstruction<Format::L>(info, instruction.rd, instruction.rs1, 0, imm);
+  return 1;
 }
@@ -4,27 +4,17 @@
 #define INSTRUCTIONL_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionL : public Instruction
+// Load 指令（lb/lh/lw）的解析与编码
+class InstructionL
 {
 public:
-  InstructionL(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-protected:
-  void parseOperands();
-
-private:
-  uint32_t rd;
-  uint32_t rs1;
-  int32_t imm;
-
-  // Load 指令的 opcode 和 funct3 映射表
-  static const std::unordered_map<std::string, uint32_t> opcodeMap;
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONL_HPP
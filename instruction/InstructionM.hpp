@@ -2,27 +2,17 @@
 #define INSTRUCTIONM_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionM : public Instruction
+// M 扩展指令（mul/mulh/mulhsu/mulhu/div/rem/remu）的解析与编码
+class InstructionM
 {
 public:
-  InstructionM(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-private:
-  void parseOperands();
-
-  uint32_t rd;
-  uint32_t rs1;
-  uint32_t rs2;
-
-  // 操作码和功能码映射表
-  static const uint32_t opcodeVal;
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
-  static const std::unordered_map<std::string, uint32_t> funct7Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONM_HPP
@@ -1,4 +1,5 @@
 // #include "InstructionP.hpp"
+#include "Encoding.hpp"
 // #include "../utils/Utils.hpp"
 // #include "../relocation_table/RelocationTable.hpp"
 // #include <stdexcept>
@@ -324,176 +325,103 @@
 #include "../relocation_table/RelocationTable.hpp"
 #include <stdexcept>
 
-// 构造函数，解析指令行和操作数
-InstructionP::InstructionP(const std::string &line)
+// 解析操作数，根据伪指令类型确定展开后实际指令的操作数
+void InstructionP::decode(const Operands &operands, Instruction &instruction)
 {
-  parseLine(line);
-  parseOperands();
-}
-
-// 解析操作数，根据伪指令类型展开实际指令
-void InstructionP::parseOperands()
-{
-  if (opcode == "mv")
+  switch (instruction.op)
   {
-    if (operands.size() != 2)
+  case Opcode::Mv:
+    if (operands.count != 2)
     {
-      throw std::runtime_error("Invalid operands for mv: " + opcode);
+      throw std::runtime_error("Invalid operands for mv: " + instruction.mnemonic());
     }
     // mv rd, rs => addi rd, rs, 0
-    expandedOpcode = "addi";
-    expandedOperands = {operands[0], operands[1], "0"};
-  }
-  else if (opcode == "li")
-  {
-    if (operands.size() != 2)
+    instruction.rd = Instruction::registerNumber(operands[0]);
+    instruction.rs1 = Instruction::registerNumber(operands[1]);
+    break;
+  case Opcode::Li:
+    if (operands.count != 2)
     {
-      throw std::runtime_error("Invalid operands for li: " + opcode);
+      throw std::runtime_error("Invalid operands for li: " + instruction.mnemonic());
     }
-    // li rd, imm
-    expandedOpcode = "li_expand";
-    expandedOperands = operands;
-  }
-  else if (opcode == "j")
-  {
-    if (operands.size() != 1)
+    // li rd, imm：立即数为符号时展开为 lui + addi
+    instruction.rd = Instruction::registerNumber(operands[0]);
     {
-      throw std::runtime_error("Invalid operands for j: " + opcode);
+      ParseStatus status = Utils::parseImmediate(operands[1], instruction.imm);
+      uint32_t number;
+      bool forward;
+      if (status == ParseStatus::NotNumber || (status == ParseStatus::Invalid && Utils::parseLocalLabelReference(operands[1], number, forward)))
+      {
+        instruction.symbol = StringPool::intern(operands[1]);
+      }
+      else if (status != ParseStatus::Ok)
+      {
+        throw Utils::immediateError(status, operands[1]);
+      }
+    }
+    break;
+  case Opcode::J:
+    if (operands.count != 1)
+    {
+      throw std::runtime_error("Invalid operands for j: " + instruction.mnemonic());
     }
     // j label => jal x0, label
-    expandedOpcode = "jal";
-    expandedOperands = {"x0", operands[0]};
-  }
-  else if (opcode == "nop")
-  {
+    instruction.symbol = StringPool::intern(operands[0]);
+    break;
+  case Opcode::Nop:
     // nop => addi x0, x0, 0
-    expandedOpcode = "addi";
-    expandedOperands = {"x0", "x0", "0"};
-  }
-  else if (opcode == "call")
-  {
-    if (operands.size() != 1)
+    break;
+  case Opcode::Call:
+    if (operands.count != 1)
     {
-      throw std::runtime_error("Invalid operands for call: " + opcode);
+      throw std::runtime_error("Invalid operands for call: " + instruction.mnemonic());
     }
-    // call label => auipc x6, %pcrel_hi(label); jalr x1, x6, %pcrel_lo(label)
-    expandedOpcode = "call_expand";
-    expandedOperands = operands;
-  }
-  else if (opcode == "ret")
-  {
+    // call label => auipc x5, %pcrel_hi(label); jalr x1, x5, %pcrel_lo(label)
+    instruction.symbol = StringPool::intern(operands[0]);
+    break;
+  case Opcode::Ret:
     // ret => jalr x0, x1, 0
-    expandedOpcode = "jalr";
-    expandedOperands = {"x0", "x1", "0"};
-  }
-  else
-  {
-    throw std::runtime_error("Unsupported pseudo-instruction: " + opcode);
+    instruction.rs1 = 1;
+    break;
+  default:
+    throw std::runtime_error("Unsupported pseudo-instruction: " + instruction.mnemonic());
   }
 }
 
-// 编码指令，处理展开后的实际指令
-std::vector<uint32_t> InstructionP::encode(
-    const SymbolTable &symbolTable,
-    RelocationTable &relocationTable,
-    std::unordered_map<std::string, Section> &sectionTable,
-    uint32_t currentAddress,
-    std::string currentSecName)
+// 编码指令，处理展开后的实际指令（各条实际指令的字段取自操作码表）
+size_t InstructionP::encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups)
 {
-  std::vector<uint32_t> instructions;
+  size_t count = 0;
+  uint32_t rd = instruction.rd;
 
-  if (expandedOpcode == "addi")
+  switch (instruction.op)
   {
-    // 处理 addi 指令
-    uint32_t rd = Utils::getRegisterNumber(expandedOperands[0]);
-    uint32_t rs1 = Utils::getRegisterNumber(expandedOperands[1]);
-    int32_t imm = Utils::stringToImmediate(expandedOperands[2]);
-
-    // 检查立即数范围
-    if (imm < -2048 || imm > 2047)
-    {
-      throw std::runtime_error("Immediate value out of range for addi: " + std::to_string(imm));
-    }
-
-    uint32_t instruction = 0x13; // opcode for addi
-    instruction |= (rd & 0x1F) << 7;
-    instruction |= (0x0 & 0x7) << 12; // funct3 = 0
-    instruction |= (rs1 & 0x1F) << 15;
-    instruction |= (imm & 0xFFF) << 20;
-
-    instructions.push_back(instruction);
+  case Opcode::Mv:
+  case Opcode::Nop:
+  {
+    // 展开为 addi rd, rs1, 0
+    out[count++] = packInstruction<Format::I>(Opcode::Addi, rd, instruction.rs1, 0, 0);
+    break;
   }
-  else if (expandedOpcode == "li_expand")
+  case Opcode::Li:
   {
     // 处理 li 指令的展开
-    uint32_t rd = Utils::getRegisterNumber(expandedOperands[0]);
-    std::string immStr = expandedOperands[1];
-
-    // 检查立即数是否为符号或数值
-    if (!Utils::isNumber(immStr) && immStr[0] != '-')
+    if (instruction.symbol != 0)
     {
-      // 立即数是符号，展开为 lui 和 addi
-      if (symbolTable.hasSymbol(immStr))
-      {
-        uint32_t symbolAddress = symbolTable.getSymbol(immStr).getGAddress();
-        uint32_t luiImm = (symbolAddress + 0x800) >> 12;
-        uint32_t addiImm = symbolAddress & 0xFFF;
-
-        // 生成 lui 指令
-        uint32_t luiInstr = 0x37; // opcode for lui
-        luiInstr |= (rd & 0x1F) << 7;
-        luiInstr |= (luiImm & 0xFFFFF) << 12;
-        instructions.push_back(luiInstr);
-
-        // 生成 addi 指令
-        uint32_t addiInstr = 0x13; // opcode for addi
-        addiInstr |= (rd & 0x1F) << 7;
-        addiInstr |= (0x0 & 0x7) << 12; // funct3 = 0
-        addiInstr |= (rd & 0x1F) << 15;
-        addiInstr |= (addiImm & 0xFFF) << 20;
-        instructions.push_back(addiInstr);
-      }
-      else
-      {
-        // 符号未知，添加重定位条目
-        // 生成 lui 指令
-        uint32_t luiInstr = 0x37; // opcode for lui
-        luiInstr |= (rd & 0x1F) << 7;
-        instructions.push_back(luiInstr);
-
-        relocationTable.addRelocation(
-            currentSecName,
-            currentAddress,
-            immStr,
-            RelocationType::R_RISCV_HI20);
-
-        // 生成 addi 指令
-        uint32_t addiInstr = 0x13; // opcode for addi
-        addiInstr |= (rd & 0x1F) << 7;
-        addiInstr |= (0x0 & 0x7) << 12; // funct3 = 0
-        addiInstr |= (rd & 0x1F) << 15;
-        instructions.push_back(addiInstr);
-
-        relocationTable.addRelocation(
-            currentSecName,
-            currentAddress + 4,
-            immStr,
-            RelocationType::R_RISCV_LO12_I);
-      }
+      // 立即数是符号，展开为 lui 和 addi，两个字各自回填
+      out[count++] = packInstruction<Format::U>(Opcode::Lui, rd, 0, 0, 0);
+      fixups.add(0, currentAddress, instruction.symbol, FixupKind::LiHi20);
+      out[count++] = packInstruction<Format::I>(Opcode::Addi, rd, rd, 0, 0);
+      fixups.add(1, currentAddress + 4, instruction.symbol, FixupKind::LiLo12);
     }
     else
     {
       // 立即数是数值
-      int32_t imm = Utils::stringToImmediate(immStr);
-      if (imm >= -2048 && imm <= 2047)
+      int32_t imm = instruction.imm;
+      if (OpcodeTable::fitsImmediate(ImmKind::I12, imm))
       {
-        // 可以直接使用 addi 指令
-        uint32_t instruction = 0x13; // opcode for addi
-        instruction |= (rd & 0x1F) << 7;
-        instruction |= (0x0 & 0x7) << 12;  // funct3 = 0
-        instruction |= (0x0 & 0x1F) << 15; // rs1 = x0
-        instruction |= (imm & 0xFFF) << 20;
-        instructions.push_back(instruction);
+        // 可以直接使用 addi 指令（rs1 = x0）
+        out[count++] = packInstruction<Format::I>(Opcode::Addi, rd, 0, 0, imm);
       }
       else
       {
@@ -501,157 +429,57 @@ std::vector<uint32_t> InstructionP::encode(
         uint32_t luiImm = (imm + 0x800) >> 12;
         int32_t addiImm = imm - (luiImm << 12);
 
-        // 生成 lui 指令
-        uint32_t luiInstr = 0x37; // opcode for lui
-        luiInstr |= (rd & 0x1F) << 7;
-        luiInstr |= (luiImm & 0xFFFFF) << 12;
-        instructions.push_back(luiInstr);
-
-        // 生成 addi 指令
-        uint32_t addiInstr = 0x13; // opcode for addi
-        addiInstr |= (rd & 0x1F) << 7;
-        addiInstr |= (0x0 & 0x7) << 12; // funct3 = 0
-        addiInstr |= (rd & 0x1F) << 15;
-        addiInstr |= (addiImm & 0xFFF) << 20;
-        instructions.push_back(addiInstr);
+        out[count++] = packInstruction<Format::U>(Opcode::Lui, rd, 0, 0, static_cast<int32_t>(luiImm));
+        out[count++] = packInstruction<Format::I>(Opcode::Addi, rd, rd, 0, addiImm);
       }
     }
+    break;
   }
-  else if (expandedOpcode == "jal")
+  case Opcode::J:
   {
-    // 处理 jal 指令
-    uint32_t rd = Utils::getRegisterNumber(expandedOperands[0]);
-    std::string label = expandedOperands[1];
-    int32_t imm = 0;
-
-    if (symbolTable.hasSymbol(label))
-    {
-      uint32_t labelAddress = symbolTable.getSymbol(label).getGAddress();
-      imm = static_cast<int32_t>(labelAddress) - static_cast<int32_t>(currentAddress);
-
-      // 检查偏移量是否对齐到 4 字节
-      if (imm % 4 != 0)
-      {
-        throw std::runtime_error("Jump target address must be 4-byte aligned.");
-      }
-
-      // 检查偏移量是否在范围内
-      if (imm < -(1 << 20) || imm >= (1 << 20))
-      {
-        throw std::runtime_error("Jump offset out of range for jal: " + std::to_string(imm));
-      }
-    }
-    else
-    {
-      // 符号未知，立即数设为 0，添加重定位条目
-      imm = 0;
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          label,
-          RelocationType::R_RISCV_JAL);
-    }
-
-    // 编码 jal 指令
-    uint32_t opcodeVal = 0x6F; // opcode for jal
-
-    uint32_t imm20 = (imm >> 20) & 0x1;     // imm[20]
-    uint32_t imm10_1 = (imm >> 1) & 0x3FF;  // imm[10:1]
-    uint32_t imm11 = (imm >> 11) & 0x1;     // imm[11]
-    uint32_t imm19_12 = (imm >> 12) & 0xFF; // imm[19:12]
-
-    uint32_t instruction = 0;
-    instruction |= (imm20 << 31);
-    instruction |= (imm19_12 << 12);
-    instruction |= (imm11 << 20);
-    instruction |= (imm10_1 << 21);
-    instruction |= (rd & 0x1F) << 7;
-    instruction |= opcodeVal;
-
-    instructions.push_back(instruction);
+    // 展开为 jal x0, label
+    out[count++] = packInstruction<Format::J>(Opcode::Jal, rd, 0, 0, 0);
+    fixups.add(0, currentAddress, instruction.symbol, FixupKind::JalPseudo);
+    break;
   }
-  else if (expandedOpcode == "call_expand")
+  case Opcode::Call:
   {
-    // 处理 call 指令的展开
-    std::string label = expandedOperands[0];
-    uint32_t rd = 1;     // x1，用于保存返回地址
-    uint32_t tmpReg = 5; // 使用 x5 作为临时寄存器
-
-    if (symbolTable.hasSymbol(label))
-    {
-      uint32_t labelAddress = symbolTable.getSymbol(label).getGAddress();
-      int32_t offset = static_cast<int32_t>(labelAddress) - static_cast<int32_t>(currentAddress);
-
-      uint32_t auipcImm = (offset + 0x800) >> 12;
-      int32_t jalrImm = offset - (auipcImm << 12);
-
-      // 生成 auipc 指令
-      uint32_t auipcInstr = 0x17; // opcode for auipc
-      auipcInstr |= (tmpReg & 0x1F) << 7;
-      auipcInstr |= (auipcImm & 0xFFFFF) << 12;
-      instructions.push_back(auipcInstr);
-
-      // 生成 jalr 指令
-      uint32_t jalrInstr = 0x67; // opcode for jalr
-      jalrInstr |= (rd & 0x1F) << 7;
-      jalrInstr |= (0x0 & 0x7) << 12; // funct3 = 0
-      jalrInstr |= (tmpReg & 0x1F) << 15;
-      jalrInstr |= (jalrImm & 0xFFF) << 20;
-      instructions.push_back(jalrInstr);
-    }
-    else
-    {
-      // 符号未知，添加重定位条目
-      // 生成 auipc 指令
-      uint32_t auipcInstr = 0x17; // opcode for auipc
-      auipcInstr |= (tmpReg & 0x1F) << 7;
-      instructions.push_back(auipcInstr);
-
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          label,
-          RelocationType::R_RISCV_PCREL_HI20);
-
-      // 生成 jalr 指令
-      uint32_t jalrInstr = 0x67; // opcode for jalr
-      jalrInstr |= (rd & 0x1F) << 7;
-      jalrInstr |= (0x0 & 0x7) << 12; // funct3 = 0
-      jalrInstr |= (tmpReg & 0x1F) << 15;
-      instructions.push_back(jalrInstr);
-
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress + 4,
-          label,
-          RelocationType::R_RISCV_PCREL_LO12_I);
-    }
+    // 展开为 auipc x5, %pcrel_hi(label); jalr x1, x5, %pcrel_lo(label)
+    uint32_t linkReg = 1; // x1，用于保存返回地址
+    uint32_t tmpReg = 5;  // 使用 x5 作为临时寄存器
+
+    out[count++] = packInstruction<Format::U>(Opcode::Auipc, tmpReg, 0, 0, 0);
+    fixups.add(0, currentAddress, instruction.symbol, FixupKind::CallHi20);
+    out[count++] = packInstruction<Format::I>(Opcode::Jalr, linkReg, tmpReg, 0, 0);
+    fixups.add(1, currentAddress + 4, instruction.symbol, FixupKind::CallLo12);
+    break;
   }
-  else if (expandedOpcode == "jalr")
+  case Opcode::Ret:
   {
-    // 处理 jalr 指令
-    uint32_t rd = Utils::getRegisterNumber(expandedOperands[0]);
-    uint32_t rs1 = Utils::getRegisterNumber(expandedOperands[1]);
-    int32_t imm = Utils::stringToImmediate(expandedOperands[2]);
-
-    // 检查立即数范围
-    if (imm < -2048 || imm > 2047)
-    {
-      throw std::runtime_error("Immediate value out of range for jalr: " + std::to_string(imm));
-    }
+    // 展开为 jalr x0, x1, 0
+    out[count++] = packInstruction<Format::I>(Opcode::Jalr, rd, instruction.rs1, 0, 0);
+    break;
+  }
+  default:
+    throw std::runtime_error("Unsupported expanded pseudo-instruction: " + instruction.mnemonic());
+  }
 
-    uint32_t instruction = 0x67; // opcode for jalr
-    instruction |= (rd & 0x1F) << 7;
-    instruction |= (0x0 & 0x7) << 12; // funct3 = 0
-    instruction |= (rs1 & 0x1F) << 15;
-    instruction |= (imm & 0xFFF) << 20;
+  return count;
+}
 
-    instructions.push_back(instruction);
+size_t InstructionP::getEncodedLength(const Instruction &instruction)
+{
+  if (instruction.op == Opcode::Call)
+  {
+    return 2;
   }
-  else
+  if (instruction.op == Opcode::Li)
   {
-    throw std::runtime_error("Unsupported expanded pseudo-instruction: " + expandedOpcode);
+    if (instruction.symbol != 0)
+    {
+      return 2;
+    }
+    return OpcodeTable::fitsImmediate(ImmKind::I12, instruction.imm) ? 1 : 2;
   }
-
-  return instructions;
+  return 1;
 }
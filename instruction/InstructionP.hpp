@@ -2,24 +2,20 @@
 #define INSTRUCTIONP_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionP : public Instruction
+// 伪指令（mv/li/j/nop/call/ret）的解析与编码，编码时展开为实际指令
+class InstructionP
 {
 public:
-  InstructionP(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 
-private:
-  void parseOperands();
-  std::string expandedOpcode;
-  std::vector<std::string> expandedOperands;
-
-  uint32_t rd;
-  uint32_t rs1;
-  int32_t imm;
+  // 展开后的机器码字数
+  static size_t getEncodedLength(const Instruction &instruction);
 };
 
 #endif // INSTRUCTIONP_HPP
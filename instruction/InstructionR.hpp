@@ -4,30 +4,17 @@
 #define INSTRUCTIONR_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionR : public Instruction
+// R 型指令（add/sub/and/or/xor/sll/srl）的解析与编码
+class InstructionR
 {
 public:
-  // 构造函数，接受指令行字符串
-  InstructionR(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  // 实现基类的 encode 方法，返回32位机器码
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-protected:
-  // 解析操作数，覆盖基类方法
-  void parseOperands();
-
-private:
-  uint32_t rd;  // 目标寄存器
-  uint32_t rs1; // 源寄存器1
-  uint32_t rs2; // 源寄存器2
-
-  // R 型指令的 funct3 和 funct7 映射表
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
-  static const std::unordered_map<std::string, uint32_t> funct7Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONR_HPP
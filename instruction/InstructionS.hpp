@@ -4,29 +4,17 @@
 #define INSTRUCTIONS_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionS : public Instruction
+// S 型指令（sb/sh/sw/sd）的解析与编码
+class InstructionS
 {
 public:
-  // 构造函数，接受指令行字符串
-  InstructionS(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  // 实现基类的 encode 方法，返回32位机器码
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-protected:
-  // 解析操作数
-  void parseOperands();
-
-private:
-  uint32_t rs2; // 源寄存器2
-  uint32_t rs1; // 源寄存器1（基址寄存器）
-  int32_t imm;  // 偏移量
-
-  // S 型指令的 funct3 映射表
-  static const std::unordered_map<std::string, uint32_t> funct3Map;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONS_HPP
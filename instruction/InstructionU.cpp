@@ -1,156 +1,97 @@
 // instruction/InstructionU.cpp
 
 #include "InstructionU.hpp"
+#include "Encoding.hpp"
 #include "../utils/Utils.hpp"
 #include <stdexcept>
 
-// U 型指令的 opcode 映射表
-const std::unordered_map<std::string, uint32_t> InstructionU::opcodeMap = {
-    {"lui", 0x37},
-    {"auipc", 0x17}};
-
-InstructionU::InstructionU(const std::string &line)
-{
-  parseLine(line); // 解析指令行，提取 opcode 和 operands
-  parseOperands(); // 解析操作数，提取 rd 和 imm
-}
-
-void InstructionU::parseOperands()
+// 解析操作数，提取 rd 和 imm
+void InstructionU::decode(const Operands &operands, Instruction &instruction)
 {
-  if (operands.size() != 2)
+  if (operands.count != 2)
   {
-    throw std::runtime_error("Invalid U-type instruction: " + opcode);
+    throw std::runtime_error("Invalid U-type instruction: " + instruction.mnemonic());
   }
 
   // 解析 rd
-  rd = Utils::getRegisterNumber(operands[0]);
+  instruction.rd = Instruction::registerNumber(operands[0]);
 
-  std::string immStr = operands[1];
+  std::string_view immStr = operands[1];
 
   // 检查是否为 '%' 表达式或标签
   if (!immStr.empty() && immStr[0] == '%')
   {
     size_t funcEnd = immStr.find('(');
     size_t funcStart = 1; // 跳过 '%'
-    if (funcEnd == std::string::npos)
+    if (funcEnd == std::string_view::npos)
     {
-      throw std::runtime_error("Invalid immediate format in U-type instruction: " + immStr);
+      throw std::runtime_error("Invalid immediate format in U-type instruction: " + std::string(immStr));
     }
-    immFunction = immStr.substr(funcStart, funcEnd - funcStart);
+    instruction.setFunction(immStr.substr(funcStart, funcEnd - funcStart));
     size_t symbolStart = funcEnd + 1;
     size_t symbolEnd = immStr.find(')', symbolStart);
-    if (symbolEnd == std::string::npos)
+    if (symbolEnd == std::string_view::npos)
     {
-      throw std::runtime_error("Invalid immediate format in U-type instruction: " + immStr);
+      throw std::runtime_error("Invalid immediate format in U-type instruction: " + std::string(immStr));
     }
-    immSymbol = immStr.substr(symbolStart, symbolEnd - symbolStart);
-    imm = 0; // 立即数将在链接时确定
-  }
-  else if (!immStr.empty() && !isdigit(immStr[0]) && immStr[0] != '-')
-  {
-    // 立即数是标签
-    immSymbol = immStr;
-    immFunction.clear();
-    imm = 0; // 立即数将在链接时确定
+    instruction.symbol = StringPool::intern(immStr.substr(symbolStart, symbolEnd - symbolStart)); // 立即数将在链接时确定
   }
   else
   {
-    // 立即数是简单数字
-    imm = Utils::stringToImmediate(immStr);
+    ParseStatus status = Utils::parseImmediate(immStr, instruction.imm);
+    if (status == ParseStatus::NotNumber)
+    {
+      // 立即数是标签
+      instruction.symbol = StringPool::intern(immStr); // 立即数将在链接时确定
+      return;
+    }
+    if (status != ParseStatus::Ok)
+    {
+      throw Utils::immediateError(status, immStr);
+    }
 
     // 检查立即数范围是否在 20 位范围内
-    if (imm < -(1 << 19) || imm >= (1 << 20))
+    if (!OpcodeTable::fitsImmediate(ImmKind::U20, instruction.imm))
     {
-      throw std::runtime_error("Immediate value out of range for U-type instruction: " + std::to_string(imm));
+      throw std::runtime_error("Immediate value out of range for U-type instruction: " + std::to_string(instruction.imm));
     }
-    immFunction.clear();
-    immSymbol.clear();
   }
 }
 
-std::vector<uint32_t> InstructionU::encode(
-    const SymbolTable &symbolTable,
-    RelocationTable &relocationTable,
-    std::unordered_map<std::string, Section> &sectionTable,
-    uint32_t currentAddress,
-    std::string currentSecName)
+size_t InstructionU::encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups)
 {
-  // 获取操作码
-  auto opcodeIt = opcodeMap.find(opcode);
-  if (opcodeIt == opcodeMap.end())
-  {
-    throw std::runtime_error("Unsupported U-type instruction: " + opcode);
-  }
-  uint32_t opcodeVal = opcodeIt->second;
+  const OpcodeInfo &info = OpcodeTable::info(instruction.op);
+  int32_t imm = instruction.imm;
 
-  if (!immFunction.empty())
+  if (instruction.function != ImmFunction::None)
   {
-    // 处理 '%' 表达式
-    if (symbolTable.hasSymbol(immSymbol))
+    // 处理 '%' 表达式：%hi 取绝对地址的高位，%pcrel_hi 取 PC 相对偏移的高位
+    if (instruction.function == ImmFunction::Hi)
     {
-      const Symbol &symbol = symbolTable.getSymbol(immSymbol);
-      uint32_t symbolAddress = symbol.getGAddress();
-
-      if (immFunction == "hi")
-      {
-        // 计算 %hi(symbol)
-        imm = (symbolAddress + 0x800) >> 12;
-      }
-      else if (immFunction == "pcrel_hi")
-      {
-        // 计算 PC 相对的 %pcrel_hi(symbol)
-        int32_t offset = static_cast<int32_t>(symbolAddress) - static_cast<int32_t>(currentAddress);
-        imm = (offset + 0x800) >> 12;
-      }
-      else
-      {
-        throw std::runtime_error("Unsupported immediate function: " + immFunction);
-      }
+      fixups.add(0, currentAddress, instruction.symbol, FixupKind::Hi20);
+    }
+    else if (instruction.function == ImmFunction::PcrelHi)
+    {
+      fixups.add(0, currentAddress, instruction.symbol, FixupKind::PcrelHi20);
     }
     else
     {
-      // 符号不存在，添加重定位条目
-      imm = 0;
-      RelocationType relocType = (immFunction == "hi") ? RelocationType::R_RISCV_HI20 : RelocationType::R_RISCV_PCREL_HI20;
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          immSymbol,
-          relocType);
+      fixups.add(0, currentAddress, instruction.symbol, FixupKind::UnknownHi20U, static_cast<int32_t>(instruction.functionName));
     }
+    imm = 0;
   }
-  else if (!immSymbol.empty())
+  else if (instruction.symbol != 0)
   {
     // 立即数是标签
-    if (symbolTable.hasSymbol(immSymbol))
-    {
-      const Symbol &symbol = symbolTable.getSymbol(immSymbol);
-      imm = symbol.getGAddress() >> 12;
-    }
-    else
-    {
-      // 符号不存在，添加重定位条目
-      imm = 0;
-      relocationTable.addRelocation(
-          currentSecName,
-          currentAddress,
-          immSymbol,
-          RelocationType::R_RISCV_HI20);
-    }
+    fixups.add(0, currentAddress, instruction.symbol, FixupKind::AbsU);
+    imm = 0;
   }
-  // 否则，立即数已解析
-
-  // 检查立即数范围
-  if (imm < -(1 << 19) || imm >= (1 << 20))
+  else if (!OpcodeTable::fitsImmediate(info.immKind, imm))
   {
+    // 立即数已解析，检查范围
     throw std::runtime_error("Immediate value out of range for U-type instruction: " + std::to_string(imm));
   }
 
-  // 组装指令
-  uint32_t instruction = 0;
-  instruction |= ((imm & 0xFFFFF) << 12); // 立即数部分（20 位），位于 12-31 位
-  instruction |= ((rd & 0x1F) << 7);      // 目标寄存器 rd，位于 7-11 位
-  instruction |= (opcodeVal & 0x7F);      // opcode，位于 0-6 位
-
-  return {instruction};
+  out[0] = packInstruction<Format::U>(info, instruction.rd, 0, 0, imm);
+  return 1;
 }
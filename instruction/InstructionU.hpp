@@ -4,24 +4,17 @@
 #define INSTRUCTIONU_HPP
 
 #include "Instruction.hpp"
-#include <unordered_map>
 #include <cstdint>
 
-class InstructionU : public Instruction
+// U 型指令（lui/auipc）的解析与编码
+class InstructionU
 {
 public:
-  InstructionU(const std::string &line);
+  // 由操作数填写 instruction 中本格式用到的字段
+  static void decode(const Operands &operands, Instruction &instruction);
 
-  std::vector<uint32_t> encode(const SymbolTable &symbolTable, RelocationTable &relocationTable, std::unordered_map<std::string, Section> &sectionTable, uint32_t currentAddress, std::string currentSecName) override;
-
-private:
-  void parseOperands();
-
-  uint32_t rd; // 目标寄存器
-  int32_t imm; // 20 位立即数
-
-  // 操作码映射表，用于存储 U 型指令的 opcode
-  static const std::unordered_map<std::string, uint32_t> opcodeMap;
+  // 编码为机器码写入 out，返回字数；引用符号时立即数字段留 0，登记修补记录
+  static size_t encode(const Instruction &instruction, uint32_t currentAddress, uint32_t *out, FixupList &fixups);
 };
 
 #endif // INSTRUCTIONU_HPP
@@ -0,0 +1,215 @@
+// instruction/Opcode.hpp
+
+#ifndef OPCODE_HPP
+#define OPCODE_HPP
+
+#include <string_view>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 指令格式，与 InstructionX 类一一对应
+enum class Format : uint8_t
+{
+  I,
+  L,
+  R,
+  S,
+  B,
+  U,
+  J,
+  P,
+  M
+};
+
+// 立即数的种类（决定取值范围和在指令字中的位置）
+enum class ImmKind : uint8_t
+{
+  None, // 没有立即数（R/M 型，伪指令展开时再定）
+  I12,  // I 型 12 位有符号数
+  S12,  // S 型 12 位有符号数，拆成 imm[11:5] 和 imm[4:0]
+  B13,  // 分支偏移，13 位有符号字节偏移
+  U20,  // U 型高 20 位
+  J21   // 跳转偏移，21 位有符号字节偏移
+};
+
+// 稠密的操作码编号，取值即 OpcodeTable::entries 的下标
+enum class Opcode : uint8_t
+{
+  Addi, Ori, Andi, Xori, Slli, Srli, Jalr,
+  Lb, Lh, Lw,
+  Add, Sub, And, Or, Xor, Sll, Srl,
+  Sb, Sh, Sw, Sd,
+  Beq, Bne, Blt, Bge, Bltu, Bgeu,
+  Lui, Auipc,
+  Jal,
+  Mv, Li, J, Nop, Call, Ret,
+  Mul, Mulh, Mulhsu, Mulhu, Div, Rem, Remu,
+  Count
+};
+
+// 每个操作码的编码信息（伪指令的 opcode/funct 字段不使用）
+struct OpcodeInfo
+{
+  std::string_view mnemonic;
+  Format format;
+  ImmKind immKind;
+  uint8_t opcode;
+  uint8_t funct3;
+  uint8_t funct7;
+};
+
+// 指令集描述表：每行一条指令（助记符、格式、立即数种类、opcode、funct3、funct7），
+// 各格式的位布局见 Encoding.hpp，增加一条指令只需在 Opcode 和 entries 中各加一项。
+// 助记符 -> Opcode 的散列表在编译期生成：从固定种子开始逐个尝试，
+// 直到所有助记符落在互不相同的槽里（完美散列），因此查找只需一次散列加一次比较
+class OpcodeTable
+{
+public:
+  static constexpr OpcodeInfo entries[] = {
+      {"addi", Format::I, ImmKind::I12, 0x13, 0x0, 0x00},
+      {"ori", Format::I, ImmKind::I12, 0x13, 0x6, 0x00},
+      {"andi", Format::I, ImmKind::I12, 0x13, 0x7, 0x00},
+      {"xori", Format::I, ImmKind::I12, 0x13, 0x4, 0x00},
+      {"slli", Format::I, ImmKind::I12, 0x13, 0x1, 0x00},
+      {"srli", Format::I, ImmKind::I12, 0x13, 0x5, 0x00},
+      {"jalr", Format::I, ImmKind::I12, 0x67, 0x0, 0x00},
+      {"lb", Format::L, ImmKind::I12, 0x03, 0x0, 0x00},
+      {"lh", Format::L, ImmKind::I12, 0x03, 0x1, 0x00},
+      {"lw", Format::L, ImmKind::I12, 0x03, 0x2, 0x00},
+      {"add", Format::R, ImmKind::None, 0x33, 0x0, 0x00},
+      {"sub", Format::R, ImmKind::None, 0x33, 0x0, 0x20},
+      {"and", Format::R, ImmKind::None, 0x33, 0x7, 0x00},
+      {"or", Format::R, ImmKind::None, 0x33, 0x6, 0x00},
+      {"xor", Format::R, ImmKind::None, 0x33, 0x4, 0x00},
+      {"sll", Format::R, ImmKind::None, 0x33, 0x1, 0x00},
+      {"srl", Format::R, ImmKind::None, 0x33, 0x5, 0x00},
+      {"sb", Format::S, ImmKind::S12, 0x23, 0x0, 0x00},
+      {"sh", Format::S, ImmKind::S12, 0x23, 0x1, 0x00},
+      {"sw", Format::S, ImmKind::S12, 0x23, 0x2, 0x00},
+      {"sd", Format::S, ImmKind::S12, 0x23, 0x3, 0x00},
+      {"beq", Format::B, ImmKind::B13, 0x63, 0x0, 0x00},
+      {"bne", Format::B, ImmKind::B13, 0x63, 0x1, 0x00},
+      {"blt", Format::B, ImmKind::B13, 0x63, 0x4, 0x00},
+      {"bge", Format::B, ImmKind::B13, 0x63, 0x5, 0x00},
+      {"bltu", Format::B, ImmKind::B13, 0x63, 0x6, 0x00},
+      {"bgeu", Format::B, ImmKind::B13, 0x63, 0x7, 0x00},
+      {"lui", Format::U, ImmKind::U20, 0x37, 0x0, 0x00},
+      {"auipc", Format::U, ImmKind::U20, 0x17, 0x0, 0x00},
+      {"jal", Format::J, ImmKind::J21, 0x6F, 0x0, 0x00},
+      {"mv", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"li", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"j", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"nop", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"call", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"ret", Format::P, ImmKind::None, 0x00, 0x0, 0x00},
+      {"mul", Format::M, ImmKind::None, 0x33, 0x0, 0x01},
+      {"mulh", Format::M, ImmKind::None, 0x33, 0x1, 0x01},
+      {"mulhsu", Format::M, ImmKind::None, 0x33, 0x2, 0x01},
+      {"mulhu", Format::M, ImmKind::None, 0x33, 0x3, 0x01},
+      {"div", Format::M, ImmKind::None, 0x33, 0x4, 0x01},
+      {"rem", Format::M, ImmKind::None, 0x33, 0x6, 0x01},
+      {"remu", Format::M, ImmKind::None, 0x33, 0x7, 0x01},
+  };
+
+  static constexpr size_t COUNT = sizeof(entries) / sizeof(entries[0]);
+  static_assert(COUNT == static_cast<size_t>(Opcode::Count), "entries 必须与 Opcode 一一对应");
+
+  // 查询助记符，不是已知指令时返回 false
+  static bool lookup(std::string_view mnemonic, Opcode &op)
+  {
+    uint8_t index = slots[hash(mnemonic, seed) & (SLOT_COUNT - 1)];
+    if (index == EMPTY_SLOT || entries[index].mnemonic != mnemonic)
+    {
+      return false;
+    }
+    op = static_cast<Opcode>(index);
+    return true;
+  }
+
+  static constexpr const OpcodeInfo &info(Opcode op)
+  {
+    return entries[static_cast<size_t>(op)];
+  }
+
+  // 立即数是否在该种类的取值范围内（B13/J21 为字节偏移）
+  static constexpr bool fitsImmediate(ImmKind kind, int32_t imm)
+  {
+    switch (kind)
+    {
+    case ImmKind::I12:
+    case ImmKind::S12:
+      return imm >= -2048 && imm <= 2047;
+    case ImmKind::B13:
+      return imm >= -8192 && imm <= 8191;
+    case ImmKind::U20:
+      return imm >= -(1 << 19) && imm < (1 << 20);
+    case ImmKind::J21:
+      return imm >= -(1 << 20) && imm < (1 << 20);
+    default:
+      return true;
+    }
+  }
+
+private:
+  static constexpr size_t SLOT_COUNT = 256;
+  static constexpr uint8_t EMPTY_SLOT = 0xFF;
+
+  static constexpr uint32_t hash(std::string_view text, uint32_t seed)
+  {
+    uint32_t h = seed;
+    for (char c : text)
+    {
+      h = (h ^ static_cast<uint8_t>(c)) * 0x01000193u;
+    }
+    return h ^ (h >> 15);
+  }
+
+  static constexpr bool isPerfect(uint32_t seed)
+  {
+    bool used[SLOT_COUNT] = {};
+    for (const OpcodeInfo &entry : entries)
+    {
+      size_t slot = hash(entry.mnemonic, seed) & (SLOT_COUNT - 1);
+      if (used[slot])
+      {
+        return false;
+      }
+      used[slot] = true;
+    }
+    return true;
+  }
+
+  static constexpr uint32_t findSeed()
+  {
+    uint32_t seed = 0x811C9DC5u;
+    while (!isPerfect(seed))
+    {
+      seed++;
+    }
+    return seed;
+  }
+
+  static constexpr std::array<uint8_t, SLOT_COUNT> buildSlots(uint32_t seed)
+  {
+    std::array<uint8_t, SLOT_COUNT> result{};
+    for (uint8_t &slot : result)
+    {
+      slot = EMPTY_SLOT;
+    }
+    for (size_t i = 0; i < COUNT; i++)
+    {
+      result[hash(entries[i].mnemonic, seed) & (SLOT_COUNT - 1)] = static_cast<uint8_t>(i);
+    }
+    return result;
+  }
+
+  // 在类定义完整之后才能调用上面的 constexpr 函数，定义见类外
+  static const uint32_t seed;
+  static const std::array<uint8_t, SLOT_COUNT> slots;
+};
+
+inline constexpr uint32_t OpcodeTable::seed = OpcodeTable::findSeed();
+inline constexpr std::array<uint8_t, OpcodeTable::SLOT_COUNT> OpcodeTable::slots = OpcodeTable::buildSlots(OpcodeTable::seed);
+
+#endif // OPCODE_HPP
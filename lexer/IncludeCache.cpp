@@ -0,0 +1,75 @@
+// lexer/IncludeCache.cpp
+
+#include "IncludeCache.hpp"
+#include "../utils/Utils.hpp"
+#include <climits>
+#include <cstdlib>
+#include <sys/stat.h>
+
+IncludeCache &IncludeCache::instance()
+{
+  static IncludeCache cache;
+  return cache;
+}
+
+std::shared_ptr<const TokenArena> IncludeCache::get(const std::string &path)
+{
+  IncludeCache &cache = instance();
+
+  // 同一个文件的不同写法（./a.s、dir/../a.s）共用一项
+  char resolved[PATH_MAX];
+  std::string key = realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+  struct stat st;
+  if (stat(key.c_str(), &st) != 0)
+  {
+    return nullptr;
+  }
+  int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+  std::shared_ptr<Entry> &slot = cache.entries[key];
+  if (slot && slot->mtime == mtime && slot->size == st.st_size)
+  {
+    cache.hits++;
+    return std::shared_ptr<const TokenArena>(slot, &slot->tokens);
+  }
+
+  // 文件被改动过（或第一次包含）：映射文件并计算内容哈希，内容没变时丢弃这次映射
+  auto entry = std::make_shared<Entry>();
+  if (!entry->source.open(key))
+  {
+    cache.entries.erase(key);
+    return nullptr;
+  }
+  entry->mtime = mtime;
+  entry->size = st.st_size;
+  entry->hash = Utils::hashBytes(entry->source.getText());
+  if (slot && slot->hash == entry->hash)
+  {
+    cache.hits++;
+    slot->mtime = mtime;
+    slot->size = st.st_size;
+    return std::shared_ptr<const TokenArena>(slot, &slot->tokens);
+  }
+
+  cache.misses++;
+  const std::vector<std::string_view> &lines = entry->source.buildLineIndex();
+  entry->tokens.reset(entry->source.getText().data());
+  Lexer::lex(lines, entry->tokens);
+  slot = std::move(entry); // 旧项由仍在使用它的调用方释放
+  return std::shared_ptr<const TokenArena>(slot, &slot->tokens);
+}
+
+size_t IncludeCache::getHits()
+{
+  return instance().hits;
+}
+
+size_t IncludeCache::getMisses()
+{
+  return instance().misses;
+}
+
+size_t IncludeCache::size()
+{
+  return instance().entries.size();
+}
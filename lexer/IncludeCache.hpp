@@ -0,0 +1,47 @@
+// lexer/IncludeCache.hpp
+
+#ifndef INCLUDE_CACHE_HPP
+#define INCLUDE_CACHE_HPP
+
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include "Lexer.hpp"
+#include "../utils/SourceBuffer.hpp"
+
+// 进程级的 .include 文件缓存：以规范化路径为键保存映射后的文件和分词结果，每个文件只留一项。
+// 同一个头文件在批量或常驻进程中被包含多次时只分词一次；修改时间和大小不变时不再读文件，
+// 变化时重新计算内容哈希，内容确实变了才重新分词并替换旧项。
+// 调用方持有返回的指针期间（如跨两遍扫描），旧项被替换后仍然有效
+class IncludeCache
+{
+public:
+  // 取得文件的词法单元流，文件无法打开时返回 nullptr
+  static std::shared_ptr<const TokenArena> get(const std::string &path);
+
+  // 命中 / 未命中次数
+  static size_t getHits();
+  static size_t getMisses();
+
+  // 缓存的文件个数
+  static size_t size();
+
+private:
+  struct Entry
+  {
+    int64_t mtime = 0; // 修改时间（纳秒）
+    int64_t size = 0;
+    uint64_t hash = 0; // 内容哈希
+    SourceBuffer source;
+    TokenArena tokens;
+  };
+
+  static IncludeCache &instance();
+
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries;
+  size_t hits = 0;
+  size_t misses = 0;
+};
+
+#endif // INCLUDE_CACHE_HPP
@@ -0,0 +1,260 @@
+// lexer/Lexer.cpp
+
+#include "Lexer.hpp"
+#include "../utils/Utils.hpp"
+#include "../utils/LineScanner.hpp"
+#include <algorithm>
+#include <cctype>
+#include <thread>
+
+namespace
+{
+  inline bool isIdentStart(char c)
+  {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$';
+  }
+
+  inline bool isIdentChar(char c)
+  {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$';
+  }
+}
+
+void TokenArena::reset(const char *base)
+{
+  this->base = base;
+  tokens.clear();
+  lines.clear();
+}
+
+const char *TokenArena::getBase() const
+{
+  return base;
+}
+
+std::string_view TokenArena::text(const Token &token) const
+{
+  return std::string_view(base + token.offset, token.length);
+}
+
+std::string_view TokenArena::text(const LexedLine &line) const
+{
+  return std::string_view(base + line.offset, line.length);
+}
+
+const Token *TokenArena::begin(const LexedLine &line) const
+{
+  return tokens.data() + line.firstToken;
+}
+
+const Token *TokenArena::end(const LexedLine &line) const
+{
+  return tokens.data() + line.firstToken + line.tokenCount;
+}
+
+const std::vector<LexedLine> &TokenArena::getLines() const
+{
+  return lines;
+}
+
+void Lexer::lex(const std::vector<std::string_view> &lines, TokenArena &arena)
+{
+  // clang 输出平均每行 3~4 个词法单元
+  arena.tokens.reserve(arena.tokens.size() + lines.size() * 4);
+  arena.lines.reserve(arena.lines.size() + lines.size());
+  for (std::string_view line : lines)
+  {
+    lexLine(line, arena);
+  }
+}
+
+void Lexer::lexLine(std::string_view line, TokenArena &arena)
+{
+  LexedLine lexed;
+  lexed.offset = static_cast<uint32_t>(line.data() - arena.base);
+  lexed.length = static_cast<uint32_t>(line.size());
+  lexed.firstToken = static_cast<uint32_t>(arena.tokens.size());
+  if (line.back() == ':')
+  {
+    lexed.kind = LineKind::Label;
+  }
+  else if (line[0] == '.')
+  {
+    lexed.kind = LineKind::Directive;
+  }
+  else
+  {
+    lexed.kind = LineKind::Instruction;
+  }
+
+  size_t i = 0;
+  while (i < line.size())
+  {
+    char c = line[i];
+    if (c == ' ' || c == '\t' || c == '\r')
+    {
+      i++;
+      continue;
+    }
+
+    Token token;
+    token.offset = lexed.offset + static_cast<uint32_t>(i);
+    token.value = 0;
+    size_t start = i;
+
+    if (std::isdigit(static_cast<unsigned char>(c)) ||
+        ((c == '-' || c == '+') && i + 1 < line.size() && std::isdigit(static_cast<unsigned char>(line[i + 1]))))
+    {
+      i++;
+      while (i < line.size() && isIdentChar(line[i]))
+      {
+        i++;
+      }
+      token.kind = Utils::parseImmediate(line.substr(start, i - start), token.value) == ParseStatus::Ok ? TokenKind::Integer : TokenKind::Identifier;
+    }
+    else if (isIdentStart(c))
+    {
+      while (i < line.size() && isIdentChar(line[i]))
+      {
+        i++;
+      }
+      token.kind = TokenKind::Identifier;
+      uint32_t reg;
+      if (Utils::tryGetRegisterNumber(line.substr(start, i - start), reg))
+      {
+        token.kind = TokenKind::Register;
+        token.value = static_cast<int32_t>(reg);
+      }
+    }
+    else if (c == '\'')
+    {
+      // 字符字面量 'c' 或 '\c'，整体作为一个词法单元（其中的逗号、括号不参与切分）
+      i++;
+      if (i < line.size() && line[i] == '\\')
+      {
+        i++;
+      }
+      i = std::min(i + 1, line.size());
+      if (i < line.size() && line[i] == '\'')
+      {
+        i++;
+      }
+      token.kind = Utils::parseImmediate(line.substr(start, i - start), token.value) == ParseStatus::Ok ? TokenKind::Integer : TokenKind::Other;
+    }
+    else if (c == '"')
+    {
+      i++;
+      while (i < line.size() && line[i] != '"')
+      {
+        i += (line[i] == '\\') ? 2 : 1;
+      }
+      i = std::min(i + 1, line.size());
+      token.kind = TokenKind::String;
+    }
+    else
+    {
+      i++;
+      switch (c)
+      {
+      case ',':
+        token.kind = TokenKind::Comma;
+        break;
+      case ':':
+        token.kind = TokenKind::Colon;
+        break;
+      case '(':
+        token.kind = TokenKind::LParen;
+        break;
+      case ')':
+        token.kind = TokenKind::RParen;
+        break;
+      case '%':
+        token.kind = TokenKind::Percent;
+        break;
+      default:
+        token.kind = TokenKind::Other;
+        break;
+      }
+    }
+    token.length = static_cast<uint32_t>(i - start);
+    arena.tokens.push_back(token);
+  }
+
+  lexed.tokenCount = static_cast<uint32_t>(arena.tokens.size()) - lexed.firstToken;
+  arena.lines.push_back(lexed);
+}
+
+void Lexer::lexParallel(std::string_view text, TokenArena &arena, unsigned threads)
+{
+  // 每块至少 MIN_PARALLEL_CHUNK 字节，文件小时少开线程
+  size_t chunks = std::max<size_t>(1, text.size() / MIN_PARALLEL_CHUNK);
+  threads = static_cast<unsigned>(std::min<size_t>(std::max(1u, threads), chunks));
+
+  // 块边界落在换行符之后，保证注释和字符串不会被切断
+  std::vector<size_t> bounds{0};
+  for (unsigned t = 1; t < threads; t++)
+  {
+    size_t pos = std::max(bounds.back(), text.size() / threads * t);
+    pos = text.find('\n', pos);
+    bounds.push_back(pos == std::string_view::npos ? text.size() : pos + 1);
+  }
+  bounds.push_back(text.size());
+
+  // 第一阶段：各线程独立切行、分词
+  std::vector<TokenArena> parts(threads);
+  auto lexChunk = [&](unsigned t)
+  {
+    std::vector<std::string_view> lines;
+    LineScanner::split(text.substr(bounds[t], bounds[t + 1] - bounds[t]), lines);
+    parts[t].reset(arena.base);
+    lex(lines, parts[t]);
+  };
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < threads; t++)
+  {
+    workers.emplace_back(lexChunk, t);
+  }
+  lexChunk(0);
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+  workers.clear();
+
+  // 前缀和：每块的词法单元和行在合并结果中的起始下标
+  std::vector<size_t> tokenStart(threads + 1), lineStart(threads + 1);
+  tokenStart[0] = arena.tokens.size();
+  lineStart[0] = arena.lines.size();
+  for (unsigned t = 0; t < threads; t++)
+  {
+    tokenStart[t + 1] = tokenStart[t] + parts[t].tokens.size();
+    lineStart[t + 1] = lineStart[t] + parts[t].lines.size();
+  }
+  arena.tokens.resize(tokenStart[threads]);
+  arena.lines.resize(lineStart[threads]);
+
+  // 第二阶段：各线程把自己的结果拷贝到合并后的位置，并修正行的词法单元下标
+  auto mergeChunk = [&](unsigned t)
+  {
+    std::copy(parts[t].tokens.begin(), parts[t].tokens.end(), arena.tokens.begin() + tokenStart[t]);
+    uint32_t shift = static_cast<uint32_t>(tokenStart[t]);
+    LexedLine *out = arena.lines.data() + lineStart[t];
+    for (const LexedLine &line : parts[t].lines)
+    {
+      *out = line;
+      out->firstToken += shift;
+      out++;
+    }
+    std::vector<Token>().swap(parts[t].tokens);
+    std::vector<LexedLine>().swap(parts[t].lines);
+  };
+  for (unsigned t = 1; t < threads; t++)
+  {
+    workers.emplace_back(mergeChunk, t);
+  }
+  mergeChunk(0);
+  for (std::thread &worker : workers)
+  {
+    worker.join();
+  }
+}
@@ -0,0 +1,91 @@
+// lexer/Lexer.hpp
+
+#ifndef LEXER_HPP
+#define LEXER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// 词法单元的种类
+enum class TokenKind : uint8_t
+{
+  Identifier, // 助记符、符号名、伪指令名
+  Register,   // 寄存器名，value 为寄存器编号
+  Integer,    // 整数字面量，value 为解析后的值
+  String,     // 字符串字面量（包含引号）
+  Comma,
+  Colon,
+  LParen,
+  RParen,
+  Percent, // %hi / %lo 等重定位函数的前缀
+  Other    // 其余单个字符，如 '-'、'@'
+};
+
+// 词法单元：在源文件中的偏移、长度和预解析的值，共 16 字节
+struct Token
+{
+  TokenKind kind;
+  uint32_t offset;
+  uint32_t length;
+  int32_t value;
+};
+
+// 行的种类（与原先按首尾字符判断的规则一致）
+enum class LineKind : uint8_t
+{
+  Label,
+  Directive,
+  Instruction
+};
+
+// 一行汇编代码在词法单元数组中的范围
+struct LexedLine
+{
+  LineKind kind;
+  uint32_t offset;     // 行在源文件中的偏移
+  uint32_t length;     // 行长度
+  uint32_t firstToken; // 第一个词法单元的下标
+  uint32_t tokenCount; // 词法单元个数
+};
+
+// 存放整个文件的词法单元，所有偏移都相对于 base
+class TokenArena
+{
+public:
+  // 清空并设置源文件基址
+  void reset(const char *base);
+
+  const char *getBase() const;
+  std::string_view text(const Token &token) const;
+  std::string_view text(const LexedLine &line) const;
+  const Token *begin(const LexedLine &line) const;
+  const Token *end(const LexedLine &line) const;
+  const std::vector<LexedLine> &getLines() const;
+
+private:
+  friend class Lexer;
+  const char *base = nullptr;
+  std::vector<Token> tokens;
+  std::vector<LexedLine> lines;
+};
+
+class Lexer
+{
+public:
+  // 对已切分好的行（指向同一块源文本）逐行分词，每个字节只扫描一次
+  static void lex(const std::vector<std::string_view> &lines, TokenArena &arena);
+
+  // 追加一行到 arena，line 必须位于 arena 的 base 之后
+  static void lexLine(std::string_view line, TokenArena &arena);
+
+  // 并行切行并分词：在换行处把 text 切成 threads 块，每个线程把自己的块分词到独立的缓冲区，
+  // 最后按词法单元个数的前缀和拼接到 arena。结果与串行的 LineScanner::split + lex 完全相同
+  static void lexParallel(std::string_view text, TokenArena &arena, unsigned threads);
+
+  // 并行分词时每块的最小字节数，块数（即实际线程数）不超过 text.size() / MIN_PARALLEL_CHUNK
+  static constexpr size_t MIN_PARALLEL_CHUNK = 1 << 16;
+};
+
+#endif // LEXER_HPP
@@ -0,0 +1,397 @@
+// macro/MacroEngine.cpp
+
+#include "MacroEngine.hpp"
+#include "../utils/Utils.hpp"
+#include "../utils/LineScanner.hpp"
+#include <stdexcept>
+#include <cctype>
+
+namespace
+{
+  inline bool isNameChar(char c)
+  {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$';
+  }
+
+  // 把 "name" 或 "name=default" 拆开
+  void splitParam(std::string_view param, std::string &name, std::string &value)
+  {
+    size_t eq = param.find('=');
+    name = std::string(Utils::trimView(param.substr(0, eq)));
+    value = eq == std::string_view::npos ? std::string() : std::string(Utils::trimView(param.substr(eq + 1)));
+  }
+}
+
+void MacroEngine::beginMacro(std::string_view rest)
+{
+  blockKind = BlockKind::Macro;
+  header = std::string(Utils::trimView(rest));
+  if (header.empty())
+  {
+    throw std::runtime_error("Missing macro name in .macro directive");
+  }
+  body.clear();
+  depth = 1;
+}
+
+void MacroEngine::beginRept(std::string_view rest)
+{
+  blockKind = BlockKind::Rept;
+  header = std::string(Utils::trimView(rest));
+  body.clear();
+  depth = 1;
+}
+
+void MacroEngine::beginIrp(std::string_view rest)
+{
+  blockKind = BlockKind::Irp;
+  header = std::string(Utils::trimView(rest));
+  body.clear();
+  depth = 1;
+}
+
+bool MacroEngine::isRecording() const
+{
+  return depth > 0;
+}
+
+bool MacroEngine::recordLine(std::string_view directive, std::string_view line, const TokenArena *&expansion)
+{
+  expansion = nullptr;
+  if (directive == ".macro" || directive == ".rept" || directive == ".irp")
+  {
+    depth++;
+  }
+  else if (directive == ".endm" || directive == ".endr")
+  {
+    if (--depth == 0)
+    {
+      expansion = finishBlock();
+      return true;
+    }
+  }
+  body.append(line);
+  body.push_back('\n');
+  return false;
+}
+
+// 块结束：登记宏定义，或展开 .rept/.irp
+const TokenArena *MacroEngine::finishBlock()
+{
+  if (blockKind == BlockKind::Macro)
+  {
+    // .macro name a, b=1 或 .macro name a b=1
+    size_t nameEnd = 0;
+    while (nameEnd < header.size() && isNameChar(header[nameEnd]))
+    {
+      nameEnd++;
+    }
+    std::string_view paramList = Utils::trimView(std::string_view(header).substr(nameEnd));
+    if (!paramList.empty() && paramList[0] == ',')
+    {
+      paramList.remove_prefix(1);
+    }
+    Macro macro;
+    macro.index = definitions++;
+    for (const std::string &param : splitArguments(paramList))
+    {
+      std::string name, value;
+      splitParam(param, name, value);
+      macro.params.push_back(std::move(name));
+      macro.defaults.push_back(std::move(value));
+    }
+    macro.body = std::move(body);
+    macro.pieces = compile(macro.body, macro.params, macro.usesCounter);
+    macros[StringPool::intern(header.substr(0, nameEnd))] = std::move(macro);
+    body.clear();
+    return nullptr;
+  }
+
+  if (blockKind == BlockKind::Rept)
+  {
+    int32_t count = Utils::stringToImmediate(header);
+    std::string key = "R" + std::to_string(count) + '\0' + body;
+    if (const TokenArena *cached = lookup(key))
+    {
+      return cached;
+    }
+    std::string text;
+    text.reserve(body.size() * std::max(count, 0));
+    for (int32_t i = 0; i < count; i++)
+    {
+      text += body;
+    }
+    return store(key, std::move(text), true);
+  }
+
+  // .irp param, v1, v2, ...
+  std::vector<std::string> parts = splitArguments(header);
+  if (parts.empty())
+  {
+    throw std::runtime_error("Missing parameter in .irp directive");
+  }
+  std::string key = "I" + header + '\0' + body;
+  if (const TokenArena *cached = lookup(key))
+  {
+    return cached;
+  }
+  std::vector<std::string> params{parts[0]};
+  bool usesCounter = false;
+  std::vector<Piece> pieces = compile(body, params, usesCounter);
+  std::string text;
+  for (size_t i = 1; i < parts.size(); i++)
+  {
+    appendPieces(text, body, pieces, {parts[i]});
+  }
+  return store(key, std::move(text), !usesCounter);
+}
+
+bool MacroEngine::isMacro(std::string_view name) const
+{
+  Atom atom;
+  return !macros.empty() && StringPool::find(name, atom) && macros.count(atom) != 0;
+}
+
+const TokenArena *MacroEngine::expandMacro(std::string_view name, std::string_view args)
+{
+  Atom atom;
+  StringPool::find(name, atom);
+  const Macro &macro = macros.at(atom);
+
+  // 实参：按位置或按 name=value 指定，缺省时用默认值
+  std::vector<std::string> values = macro.defaults;
+  std::vector<std::string> actual = splitArguments(args);
+  size_t position = 0;
+  for (const std::string &arg : actual)
+  {
+    std::string key, value;
+    splitParam(arg, key, value);
+    bool named = false;
+    if (arg.find('=') != std::string::npos)
+    {
+      for (size_t i = 0; i < macro.params.size(); i++)
+      {
+        if (macro.params[i] == key)
+        {
+          values[i] = value;
+          named = true;
+          break;
+        }
+      }
+    }
+    if (!named)
+    {
+      if (position >= values.size())
+      {
+        throw std::runtime_error("Too many arguments for macro: " + std::string(name));
+      }
+      values[position++] = arg;
+    }
+  }
+
+  std::string key = std::to_string(macro.index);
+  for (const std::string &value : values)
+  {
+    key += '\0';
+    key += value;
+  }
+  if (!macro.usesCounter)
+  {
+    if (const TokenArena *cached = lookup(key))
+    {
+      return cached;
+    }
+  }
+  std::string text;
+  appendPieces(text, macro.body, macro.pieces, values);
+  return store(key, std::move(text), !macro.usesCounter);
+}
+
+size_t MacroEngine::getHits() const
+{
+  return hits;
+}
+
+size_t MacroEngine::getMisses() const
+{
+  return misses;
+}
+
+// 把宏体拆成模板：\name 引用参数，\() 为空分隔符，\@ 为展开序号
+std::vector<MacroEngine::Piece> MacroEngine::compile(const std::string &body, const std::vector<std::string> &params, bool &usesCounter)
+{
+  std::vector<Piece> pieces;
+  size_t literal = 0;
+  auto flush = [&](size_t end)
+  {
+    if (end > literal)
+    {
+      pieces.push_back({-1, static_cast<uint32_t>(literal), static_cast<uint32_t>(end - literal)});
+    }
+  };
+  size_t i = 0;
+  while (i < body.size())
+  {
+    if (body[i] != '\\' || i + 1 >= body.size())
+    {
+      i++;
+      continue;
+    }
+    if (body[i + 1] == '(' && i + 2 < body.size() && body[i + 2] == ')')
+    {
+      flush(i);
+      i += 3;
+      literal = i;
+      continue;
+    }
+    if (body[i + 1] == '@')
+    {
+      flush(i);
+      pieces.push_back({COUNTER_PARAM, 0, 0});
+      usesCounter = true;
+      i += 2;
+      literal = i;
+      continue;
+    }
+    size_t end = i + 1;
+    while (end < body.size() && isNameChar(body[end]))
+    {
+      end++;
+    }
+    std::string_view name(body.data() + i + 1, end - i - 1);
+    int32_t param = -1;
+    for (size_t p = 0; p < params.size(); p++)
+    {
+      if (params[p] == name)
+      {
+        param = static_cast<int32_t>(p);
+        break;
+      }
+    }
+    if (param < 0)
+    {
+      i++; // 不是形参，保留原文
+      continue;
+    }
+    flush(i);
+    pieces.push_back({param, 0, 0});
+    i = end;
+    literal = i;
+  }
+  flush(body.size());
+  return pieces;
+}
+
+// 按顶层逗号切分参数（括号和引号内的逗号不算）；没有逗号时按空白切分
+std::vector<std::string> MacroEngine::splitArguments(std::string_view args)
+{
+  std::vector<std::string> result;
+  args = Utils::trimView(args);
+  if (args.empty())
+  {
+    return result;
+  }
+  bool hasComma = false;
+  int paren = 0;
+  bool quoted = false;
+  size_t start = 0;
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    char c = args[i];
+    if (c == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (!quoted && c == '(')
+    {
+      paren++;
+    }
+    else if (!quoted && c == ')')
+    {
+      paren--;
+    }
+    else if (!quoted && paren == 0 && c == ',')
+    {
+      hasComma = true;
+      result.emplace_back(Utils::trimView(args.substr(start, i - start)));
+      start = i + 1;
+    }
+  }
+  if (hasComma)
+  {
+    result.emplace_back(Utils::trimView(args.substr(start)));
+    return result;
+  }
+  size_t i = 0;
+  while (i < args.size())
+  {
+    while (i < args.size() && (args[i] == ' ' || args[i] == '\t'))
+    {
+      i++;
+    }
+    size_t end = i;
+    while (end < args.size() && args[end] != ' ' && args[end] != '\t')
+    {
+      end++;
+    }
+    if (end > i)
+    {
+      result.emplace_back(args.substr(i, end - i));
+    }
+    i = end;
+  }
+  return result;
+}
+
+void MacroEngine::appendPieces(std::string &out, const std::string &body, const std::vector<Piece> &pieces, const std::vector<std::string> &values)
+{
+  for (const Piece &piece : pieces)
+  {
+    if (piece.param == COUNTER_PARAM)
+    {
+      out += std::to_string(counter);
+    }
+    else if (piece.param >= 0)
+    {
+      out += values[piece.param];
+    }
+    else
+    {
+      out.append(body, piece.offset, piece.length);
+    }
+  }
+  counter++;
+}
+
+const TokenArena *MacroEngine::lookup(const std::string &key)
+{
+  auto it = cache.find(key);
+  if (it == cache.end())
+  {
+    return nullptr;
+  }
+  hits++;
+  return &it->second->tokens;
+}
+
+// 对展开文本切行、分词一次并保存
+const TokenArena *MacroEngine::store(const std::string &key, std::string text, bool cacheable)
+{
+  misses++;
+  auto expansion = std::make_unique<Expansion>();
+  expansion->text = std::move(text);
+  std::vector<std::string_view> lines;
+  LineScanner::split(expansion->text, lines);
+  expansion->tokens.reset(expansion->text.data());
+  Lexer::lex(lines, expansion->tokens);
+  const TokenArena *tokens = &expansion->tokens;
+  if (cacheable)
+  {
+    cache.emplace(key, std::move(expansion));
+  }
+  else
+  {
+    uncached.push_back(std::move(expansion));
+  }
+  return tokens;
+}
@@ -0,0 +1,103 @@
+// macro/MacroEngine.hpp
+
+#ifndef MACRO_ENGINE_HPP
+#define MACRO_ENGINE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include "../lexer/Lexer.hpp"
+#include "../utils/StringPool.hpp"
+
+// 宏展开：.macro/.endm（带参数和默认值）、.rept/.endr、.irp/.endr。
+// 宏体在定义时预先拆成“原文片段 + 参数引用”的模板，展开时只做拼接。宏体本身不预先分词：
+// 参数可以出现在词法单元中间（如 x\()\r），替换后边界会变，所以拼接结果要重新切行、分词。
+// 展开结果（文本和词法单元）按参数缓存，相同参数的重复展开直接复用，不再分词；
+// 未命中缓存、含 \@ 的宏和 .rept/.irp 块第一次展开时分词一次。
+// 展开结果在引擎销毁前一直有效，可以跨两遍扫描引用
+class MacroEngine
+{
+public:
+  // 开始记录块，参数为伪指令名之后的内容
+  void beginMacro(std::string_view rest);
+  void beginRept(std::string_view rest);
+  void beginIrp(std::string_view rest);
+
+  // 是否正在记录块
+  bool isRecording() const;
+
+  // 收下一行（directive 为该行的伪指令名，不是伪指令时为空）。
+  // 块在这一行结束时返回 true；若结束的是 .rept/.irp，expansion 指向展开结果，否则为 nullptr
+  bool recordLine(std::string_view directive, std::string_view line, const TokenArena *&expansion);
+
+  // 是否定义了名为 name 的宏
+  bool isMacro(std::string_view name) const;
+
+  // 展开宏调用，args 为宏名之后的参数部分
+  const TokenArena *expandMacro(std::string_view name, std::string_view args);
+
+  // 展开缓存的命中 / 未命中次数
+  size_t getHits() const;
+  size_t getMisses() const;
+
+private:
+  // 模板片段：param < 0 时为 body 中的原文 [offset, offset + length)，否则为第 param 个参数
+  struct Piece
+  {
+    int32_t param;
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  static constexpr int32_t COUNTER_PARAM = -2; // \@：展开序号
+
+  struct Macro
+  {
+    uint32_t index;                    // 宏编号，用作缓存键的一部分；重新定义同名宏时换新编号
+    std::vector<std::string> params;   // 形参名
+    std::vector<std::string> defaults; // 默认值
+    std::string body;                  // 宏体原文（各行以换行分隔）
+    std::vector<Piece> pieces;         // 预先拆好的模板
+    bool usesCounter = false;          // 含 \@ 时每次展开都不同，不缓存
+  };
+
+  enum class BlockKind
+  {
+    Macro,
+    Rept,
+    Irp
+  };
+
+  struct Expansion
+  {
+    std::string text;
+    TokenArena tokens;
+  };
+
+  static std::vector<Piece> compile(const std::string &body, const std::vector<std::string> &params, bool &usesCounter);
+  static std::vector<std::string> splitArguments(std::string_view args);
+  void appendPieces(std::string &out, const std::string &body, const std::vector<Piece> &pieces, const std::vector<std::string> &values);
+  const TokenArena *lookup(const std::string &key);
+  const TokenArena *store(const std::string &key, std::string text, bool cache);
+  const TokenArena *finishBlock();
+
+  std::unordered_map<Atom, Macro> macros;
+
+  // 正在记录的块
+  BlockKind blockKind = BlockKind::Macro;
+  uint32_t depth = 0;    // 嵌套层数，回到 0 时块结束
+  std::string header;    // .macro 的宏名和形参 / .rept 的次数 / .irp 的形参和值
+  std::string body;
+
+  std::unordered_map<std::string, std::unique_ptr<Expansion>> cache;
+  std::vector<std::unique_ptr<Expansion>> uncached;
+  uint32_t counter = 0;
+  uint32_t definitions = 0; // 已登记的宏定义个数（含重复定义），作为下一个宏的编号
+  size_t hits = 0;
+  size_t misses = 0;
+};
+
+#endif // MACRO_ENGINE_HPP
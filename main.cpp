@@ -1,8 +1,112 @@
 #include "trunk/Assembler.hpp"
+#include "utils/Trace.hpp"
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
 
-int main()
+// 用法：assembler [--stream] [--two-pass] [--stats] [--trace 类别[,类别...]] [--trace-level 级别] [-j 线程数] [-MD] [-MF 依赖文件] [输入文件] [输出文件]
+// 输入或输出文件为 "-" 时使用标准输入 / 标准输出；--two-pass 改用原来的两遍扫描（默认一遍扫描）。两者的区别：
+// 两遍扫描不支持数字局部标签（1:、1b、1f），遇到时报错；有多处错误时一遍扫描按源文件顺序报告第一处，
+// 两遍扫描先报告标签、伪指令和指令解码中的错误，再报告编码和符号解析中的错误。其余情况输出相同；
+// --stats 在结束后向标准错误输出缓存统计；
+// --trace 向标准错误输出追踪信息，类别为 lexer、directive、encode、reloc、elf 或 all，
+// --trace-level 为 error、info 或 debug（默认）。定义 NDEBUG 编译时追踪代码不编译进程序
+int main(int argc, char *argv[])
 {
+  bool streaming = false;
+  bool twoPass = false;
+  unsigned threads = 1;
+  bool writeDeps = false;
+  bool stats = false;
+  const char *traceLevel = nullptr;
+  std::string depFile;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "--stream") == 0)
+    {
+      streaming = true;
+    }
+    else if (std::strcmp(argv[i], "--two-pass") == 0)
+    {
+      twoPass = true;
+    }
+    else if (std::strcmp(argv[i], "--stats") == 0)
+    {
+      stats = true;
+    }
+    else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+    {
+      if (!Trace::enable(argv[++i]))
+      {
+        std::cerr << "未知的追踪类别：" << argv[i] << std::endl;
+        return 1;
+      }
+    }
+    else if (std::strcmp(argv[i], "--trace-level") == 0 && i + 1 < argc)
+    {
+      traceLevel = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      // 只接受正整数，超过硬件线程数的部分由 setLexThreads 截掉
+      const char *text = argv[++i];
+      const char *end = text + std::strlen(text);
+      auto [ptr, ec] = std::from_chars(text, end, threads);
+      if (ec != std::errc() || ptr != end || threads == 0)
+      {
+        std::cerr << "无效的线程数：" << text << std::endl;
+        return 1;
+      }
+    }
+    else if (std::strcmp(argv[i], "-MD") == 0)
+    {
+      writeDeps = true;
+    }
+    else if (std::strcmp(argv[i], "-MF") == 0 && i + 1 < argc)
+    {
+      writeDeps = true;
+      depFile = argv[++i];
+    }
+    else
+    {
+      files.push_back(argv[i]);
+    }
+  }
+  if (traceLevel && !Trace::setLevel(traceLevel))
+  {
+    std::cerr << "未知的追踪级别：" << traceLevel << std::endl;
+    return 1;
+  }
+  std::string inputFile = files.size() > 0 ? files[0] : "clang.s";
+  std::string outputFile = files.size() > 1 ? files[1] : "clang.o";
+
   Assembler assembler;
-  assembler.assemble("clang.s", "clang.o", false);
+  assembler.setLexThreads(threads);
+  assembler.setTwoPass(twoPass);
+  if (writeDeps)
+  {
+    // 默认依赖文件与输出同名，扩展名换成 .d
+    if (depFile.empty())
+    {
+      size_t dot = outputFile.rfind('.');
+      size_t slash = outputFile.rfind('/');
+      bool hasExt = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+      depFile = (outputFile == "-" ? std::string("a") : hasExt ? outputFile.substr(0, dot) : outputFile) + ".d";
+    }
+    assembler.setDependencyFile(depFile);
+  }
+  if (streaming)
+  {
+    assembler.assembleStream(inputFile, outputFile);
+  }
+  else
+  {
+    assembler.assemble(inputFile, outputFile, false);
+  }
+  if (stats)
+  {
+    assembler.printStats(std::cerr);
+  }
   return 0;
-}
\ No newline at end of file
+}
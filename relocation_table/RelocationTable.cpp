@@ -1,11 +1,15 @@
 #include "RelocationTable.hpp"
 
-void RelocationTable::addRelocation(const std::string &sectionName, uint32_t offset, const std::string &symbolName, RelocationType type, int32_t addend)
+uint32_t RelocationTable::sectionIndex(Atom sectionName)
 {
-  relocations[sectionName].push_back({sectionName, offset, symbolName, type, addend});
-}
-
-const std::unordered_map<std::string, std::vector<RelocationEntry>> &RelocationTable::getRelocations() const
-{
-  return relocations;
+  for (uint32_t i = 0; i < sectionNames.size(); i++)
+  {
+    if (sectionNames[i] == sectionName)
+    {
+      return i;
+    }
+  }
+  sectionNames.push_back(sectionName);
+  relocations.emplace_back();
+  return static_cast<uint32_t>(sectionNames.size() - 1);
 }
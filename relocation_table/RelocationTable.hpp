@@ -2,10 +2,12 @@
 #define RELOCATIONTABLE_HPP
 
 #include <vector>
-#include <string>
-#include <unordered_map>
+#include <type_traits>
+#include <cstdint>
+#include "../utils/StringPool.hpp"
+#include "../symbol_table/SymbolTable.hpp"
 
-enum RelocationType
+enum RelocationType : uint32_t
 {
   R_RISCV_NONE = 0,          // 无重定位
   R_RISCV_32 = 1,            // 32 位绝对重定位
@@ -26,26 +28,39 @@ enum RelocationType
   // 根据需要可以添加更多重定位类型
 };
 
+// 一个重定位项：16 字节的 POD，所在节由存放它的列表决定（见 RelocationTable）
 struct RelocationEntry
 {
-  std::string segmentName; // 重定位所在的节名
-  uint32_t offset;         // 重定位位置在节内的偏移
-  std::string symbolName;  // 符号名称
-  RelocationType type;     // 重定位类型
-  int32_t addend;          // 附加值
+  uint32_t offset;     // 重定位位置在节内的偏移
+  SymbolId symbol;     // 引用的符号在符号表中的句柄
+  RelocationType type; // 重定位类型
+  int32_t addend;      // 附加值
 };
+static_assert(sizeof(RelocationEntry) == 16 && std::is_trivially_copyable_v<RelocationEntry>, "RelocationEntry 应为 16 字节的 POD");
 
+// 重定位表：每个节一个连续的重定位项列表，以节的编号（按第一次出现重定位的顺序分配）访问
 class RelocationTable
 {
 public:
+  static constexpr uint32_t NO_SECTION = UINT32_MAX;
+
+  // 节名对应的编号，第一次出现时分配（节只有几个，线性查找）
+  uint32_t sectionIndex(Atom sectionName);
+
   // 添加一个新的重定位项
-  void addRelocation(const std::string &sectionName, uint32_t offset, const std::string &symbolName, RelocationType type, int32_t addend = 0);
+  void addRelocation(uint32_t sectionIndex, uint32_t offset, SymbolId symbol, RelocationType type, int32_t addend = 0)
+  {
+    relocations[sectionIndex].push_back({offset, symbol, type, addend});
+  }
 
-  // 获取所有重定位项
-  const std::unordered_map<std::string, std::vector<RelocationEntry>> &getRelocations() const;
+  // 节的个数，编号为 0 到 sectionCount() - 1
+  size_t sectionCount() const { return sectionNames.size(); }
+  Atom getSectionName(uint32_t sectionIndex) const { return sectionNames[sectionIndex]; }
+  const std::vector<RelocationEntry> &getRelocations(uint32_t sectionIndex) const { return relocations[sectionIndex]; }
 
 private:
-  std::unordered_map<std::string, std::vector<RelocationEntry>> relocations; // 段名到重定位项列表的映射
+  std::vector<Atom> sectionNames;                      // 编号 -> 节名
+  std::vector<std::vector<RelocationEntry>> relocations; // 编号 -> 该节的重定位项
 };
 
 #endif // RELOCATIONTABLE_HPP
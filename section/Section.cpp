@@ -2,16 +2,13 @@
 
 Section::Section()
 {
-  name = "";
   alignment = 1 << 2;
   fillValue = 0x0;
-  flags = "";
-  type = "";
   baseAddress = 0;
 }
 
 // 构造函数：初始化段的名称、对齐、标志和类型
-Section::Section(const std::string &name)
+Section::Section(Atom name)
     : name(name)
 {
   alignment = 1 << 2;
@@ -28,18 +25,33 @@ void Section::addData(const std::vector<uint8_t> &dataToAdd)
   data.insert(data.end(), dataToAdd.begin(), dataToAdd.end());
 }
 
-// 添加一条32位机器码指令（小端序）
-void Section::addInstruction(std::vector<uint32_t> &instructions)
+// 添加32位机器码指令（小端序）
+void Section::addInstruction(const uint32_t *instructions, size_t count)
 {
-  for (auto instruction : instructions)
+  size_t offset = data.size();
+  data.resize(offset + count * 4);
+  uint8_t *out = data.data() + offset;
+  for (size_t i = 0; i < count; i++)
   {
-    data.push_back(instruction & 0xFF);
-    data.push_back((instruction >> 8) & 0xFF);
-    data.push_back((instruction >> 16) & 0xFF);
-    data.push_back((instruction >> 24) & 0xFF);
+    uint32_t instruction = instructions[i];
+    out[0] = instruction & 0xFF;
+    out[1] = (instruction >> 8) & 0xFF;
+    out[2] = (instruction >> 16) & 0xFF;
+    out[3] = (instruction >> 24) & 0xFF;
+    out += 4;
   }
 }
 
+// 回填立即数：把 bits 按位或进 offset 处的指令字（小端序）
+void Section::patchInstruction(size_t offset, uint32_t bits)
+{
+  uint8_t *out = data.data() + offset;
+  out[0] |= bits & 0xFF;
+  out[1] |= (bits >> 8) & 0xFF;
+  out[2] |= (bits >> 16) & 0xFF;
+  out[3] |= (bits >> 24) & 0xFF;
+}
+
 // 对齐段内容到指定字节边界，并填充指定的字节值
 void Section::align(uint32_t alignment, uint32_t &saddress, uint32_t &gaddress, uint32_t &inSecAddress)
 {
@@ -53,7 +65,12 @@ void Section::align(uint32_t alignment, uint32_t &saddress, uint32_t &gaddress,
 }
 
 // 获取段名称
-const std::string &Section::getName() const
+std::string_view Section::getName() const
+{
+  return StringPool::str(name);
+}
+
+Atom Section::getNameId() const
 {
   return name;
 }
@@ -71,15 +88,15 @@ uint32_t Section::getAlignment() const
 }
 
 // 获取段标志
-const std::string &Section::getFlags() const
+std::string_view Section::getFlags() const
 {
-  return flags;
+  return StringPool::str(flags);
 }
 
 // 获取段类型
-const std::string &Section::getType() const
+std::string_view Section::getType() const
 {
-  return type;
+  return StringPool::str(type);
 }
 
 // 获取段的大小
@@ -88,7 +105,7 @@ uint32_t Section::getSize() const
   return data.size();
 }
 // 设置段名称
-void Section::setName(const std::string &name)
+void Section::setName(Atom name)
 {
   this->name = name;
 }
@@ -100,13 +117,13 @@ void Section::setAlignment(uint32_t alignment)
 }
 
 // 设置段标志
-void Section::setFlags(const std::string &flags)
+void Section::setFlags(Atom flags)
 {
   this->flags = flags;
 }
 
 // 设置段类型
-void Section::setType(const std::string &type)
+void Section::setType(Atom type)
 {
   this->type = type;
 }
@@ -117,7 +134,7 @@ void Section::setSectionSize(uint32_t size)
   // data.resize(size);
   section_size = size;
 }
-void Section::setSegmentName(const std::string &segmentName)
+void Section::setSegmentName(Atom segmentName)
 {
   this->segmentName = segmentName;
 }
@@ -125,7 +142,11 @@ void Section::setFillValue(uint8_t fillValue)
 {
   this->fillValue = fillValue;
 }
-const std::string &Section::getSegmentName() const
+std::string_view Section::getSegmentName() const
+{
+  return StringPool::str(segmentName);
+}
+Atom Section::getSegmentId() const
 {
   return segmentName;
 }
@@ -156,31 +156,20 @@
 //   }
 // }
 #include "SymbolTable.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 // -------------------- Symbol 类实现 --------------------
 
 Symbol::Symbol()
-    : name(""), saddress(0), gaddress(0), type(SymbolType::UNDEFINED), globalFlag(false), size(0), sectionName("")
 {
 }
 
-Symbol::Symbol(const std::string &name,
-               uint32_t saddress,
-               uint32_t gaddress,
-               SymbolType type,
-               bool isGlobal,
-               int size,
-               const std::string &sectionName)
-    : name(name), saddress(saddress), gaddress(gaddress), type(type), globalFlag(isGlobal), size(size), sectionName(sectionName)
+Symbol::Symbol(uint32_t saddress, uint32_t gaddress, SymbolType type, bool isGlobal, Atom sectionName)
+    : saddress(saddress), gaddress(gaddress), sectionName(sectionName), type(type), globalFlag(isGlobal)
 {
 }
 
-const std::string &Symbol::getName() const
-{
-  return name;
-}
-
 uint32_t Symbol::getSAddress() const
 {
   return saddress;
@@ -204,16 +193,19 @@ bool Symbol::isGlobal() const
   return globalFlag;
 }
 
-int Symbol::getSize() const
+std::string_view Symbol::getSectionName() const
 {
-  return size;
+  return StringPool::str(sectionName);
 }
-
-const std::string &Symbol::getSectionName() const
+Atom Symbol::getSectionId() const
 {
   return sectionName;
 }
-const std::string &Symbol::getSegmentName() const
+std::string_view Symbol::getSegmentName() const
+{
+  return StringPool::str(segmentName);
+}
+Atom Symbol::getSegmentId() const
 {
   return segmentName;
 }
@@ -241,16 +233,11 @@ void Symbol::setGlobal(bool isGlobal)
   globalFlag = isGlobal;
 }
 
-void Symbol::setSize(int size)
-{
-  this->size = size;
-}
-
-void Symbol::setSectionName(const std::string &sectionName)
+void Symbol::setSectionName(Atom sectionName)
 {
   this->sectionName = sectionName;
 }
-void Symbol::setSegmentName(const std::string &segmentName)
+void Symbol::setSegmentName(Atom segmentName)
 {
   this->segmentName = segmentName;
 }
@@ -258,183 +245,258 @@ void Symbol::setSegmentName(const std::string &segmentName)
 // -------------------- SymbolTable 类实现 --------------------
 
 SymbolTable::SymbolTable()
+    : slots(INITIAL_SLOTS, Slot{0, NO_SYMBOL}), shift(32 - 6)
 {
-  // 可以在这里初始化一些预定义符号（如果需要）
+  static_assert(INITIAL_SLOTS == 1 << 6, "shift 与初始容量对应");
 }
 
-void SymbolTable::addSymbol(const std::string &name,
-                            uint32_t saddress,
-                            uint32_t gaddress,
-                            SymbolType type,
-                            bool isGlobal,
-                            const std::string &sectionName)
+SymbolId SymbolTable::lookup(Atom name) const
 {
-  auto it = symbols.find(name);
-  if (it == symbols.end())
+  size_t mask = slots.size() - 1;
+  for (size_t i = home(name);; i = (i + 1) & mask)
   {
-    // 符号不存在，创建新的符号
-    symbols[name] = Symbol(name, saddress, gaddress, type, isGlobal, 0, sectionName);
-  }
-  else
-  {
-    // 符号已存在，只更新提供的属性
-    if (type != SymbolType::UNDEFINED)
-    {
-      it->second.setType(type);
-    }
-    if (saddress != 0)
-    {
-      it->second.setSAddress(saddress);
-    }
-    if (gaddress != 0)
-    {
-      it->second.setGAddress(gaddress);
-    }
-    it->second.setGlobal(isGlobal);
-    if (!sectionName.empty())
+    const Slot &slot = slots[i];
+    if (slot.id == NO_SYMBOL || slot.name == name)
     {
-      it->second.setSectionName(sectionName);
+      return slot.id;
     }
   }
 }
 
-bool SymbolTable::hasSymbol(const std::string &name) const
+SymbolId SymbolTable::find(Atom name) const
 {
-  return symbols.find(name) != symbols.end();
+  SymbolId id = lookup(name);
+  return id != NO_SYMBOL && !symbols[id].referenceOnly ? id : NO_SYMBOL;
 }
 
-Symbol &SymbolTable::getSymbol(const std::string &name)
+SymbolId SymbolTable::intern(Atom name)
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  SymbolId id = lookup(name);
+  if (id == NO_SYMBOL)
   {
-    return it->second;
+    return create(name);
   }
-  else
+  if (symbols[id].referenceOnly)
   {
-    throw std::runtime_error("Symbol not found: " + name);
+    symbols[id] = Symbol(); // 第一次在源文件中出现，按新符号处理
   }
+  return id;
 }
 
-const Symbol &SymbolTable::getSymbol(const std::string &name) const
+SymbolId SymbolTable::reference(Atom name)
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  SymbolId id = lookup(name);
+  if (id == NO_SYMBOL)
   {
-    return it->second;
+    id = create(name);
+    symbols[id].referenceOnly = true;
   }
-  else
+  return id;
+}
+
+void SymbolTable::clear()
+{
+  if (slots.size() > INITIAL_SLOTS && symbols.size() * 8 < slots.size())
   {
-    throw std::runtime_error("Symbol not found: " + name);
+    std::vector<Slot>(INITIAL_SLOTS, Slot{0, NO_SYMBOL}).swap(slots);
+    std::vector<Symbol>().swap(symbols);
+    std::vector<Atom>().swap(names);
+    std::vector<int>().swap(sizes);
+    shift = 32 - 6;
+    return;
   }
+  std::fill(slots.begin(), slots.end(), Slot{0, NO_SYMBOL});
+  symbols.clear();
+  names.clear();
+  sizes.clear();
 }
 
-void SymbolTable::updateSymbolAddress(const std::string &name, uint32_t saddress, uint32_t gaddress, uint32_t inSecAddress)
+// 添加一个未定义的新符号（调用方已确认不存在）
+SymbolId SymbolTable::create(Atom name)
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  if ((symbols.size() + 1) * 2 > slots.size())
   {
-    it->second.setSAddress(saddress);
-    it->second.setGAddress(gaddress);
-    it->second.setInSecAddress(inSecAddress);
+    grow();
   }
-  else
+  SymbolId id = static_cast<SymbolId>(symbols.size());
+  symbols.emplace_back();
+  names.push_back(name);
+  sizes.push_back(0);
+
+  size_t mask = slots.size() - 1;
+  size_t i = home(name);
+  while (slots[i].id != NO_SYMBOL)
   {
-    // 如果符号不存在，则创建新的符号并设置地址
-    symbols[name] = Symbol(name, saddress, gaddress);
+    i = (i + 1) & mask;
   }
+  slots[i] = {name, id};
+  return id;
 }
 
-void SymbolTable::setGlobal(const std::string &name, bool isGlobal)
+// 容量翻倍，按句柄顺序重新插入所有名字
+void SymbolTable::grow()
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
-  {
-    it->second.setGlobal(isGlobal);
-  }
-  else
+  slots.assign(slots.size() * 2, Slot{0, NO_SYMBOL});
+  shift--;
+  size_t mask = slots.size() - 1;
+  for (SymbolId id = 0; id < names.size(); id++)
   {
-    // 如果符号不存在，则创建新的符号并设置全局标志
-    symbols[name] = Symbol(name);
-    symbols[name].setGlobal(isGlobal);
+    size_t i = home(names[id]);
+    while (slots[i].id != NO_SYMBOL)
+    {
+      i = (i + 1) & mask;
+    }
+    slots[i] = {names[id], id};
   }
 }
 
-void SymbolTable::setType(const std::string &name, SymbolType type)
+SymbolId SymbolTable::addSymbol(Atom name,
+                                uint32_t saddress,
+                                uint32_t gaddress,
+                                SymbolType type,
+                                bool isGlobal,
+                                Atom sectionName)
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  SymbolId id = find(name);
+  if (id == NO_SYMBOL)
   {
-    it->second.setType(type);
+    // 符号不存在，创建新的符号
+    id = intern(name);
+    symbols[id] = Symbol(saddress, gaddress, type, isGlobal, sectionName);
+    return id;
   }
-  else
+
+  // 符号已存在，只更新提供的属性
+  Symbol &symbol = symbols[id];
+  if (type != SymbolType::UNDEFINED)
   {
-    // 如果符号不存在，则创建新的符号并设置类型
-    symbols[name] = Symbol(name);
-    symbols[name].setType(type);
+    symbol.setType(type);
   }
-}
-
-void SymbolTable::setSize(const std::string &name, int size)
-{
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  if (saddress != 0)
   {
-    it->second.setSize(size);
+    symbol.setSAddress(saddress);
   }
-  else
+  if (gaddress != 0)
   {
-    // 如果符号不存在，则创建新的符号并设置大小
-    symbols[name] = Symbol(name);
-    symbols[name].setSize(size);
+    symbol.setGAddress(gaddress);
   }
+  symbol.setGlobal(isGlobal);
+  if (sectionName != 0)
+  {
+    symbol.setSectionName(sectionName);
+  }
+  return id;
+}
+
+SymbolId SymbolTable::addSymbol(std::string_view name,
+                                uint32_t saddress,
+                                uint32_t gaddress,
+                                SymbolType type,
+                                bool isGlobal,
+                                std::string_view sectionName)
+{
+  return addSymbol(StringPool::intern(name), saddress, gaddress, type, isGlobal, StringPool::intern(sectionName));
 }
 
-void SymbolTable::setSectionName(const std::string &name, const std::string &sectionName)
+bool SymbolTable::hasSymbol(Atom name) const
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  return find(name) != NO_SYMBOL;
+}
+
+bool SymbolTable::hasSymbol(std::string_view name) const
+{
+  Atom atom;
+  return StringPool::find(name, atom) && hasSymbol(atom);
+}
+
+const Symbol *SymbolTable::findSymbol(Atom name) const
+{
+  SymbolId id = find(name);
+  return id != NO_SYMBOL ? &symbols[id] : nullptr;
+}
+
+Symbol &SymbolTable::getSymbol(Atom name)
+{
+  SymbolId id = find(name);
+  if (id == NO_SYMBOL)
   {
-    it->second.setSectionName(sectionName);
+    throw std::runtime_error("Symbol not found: " + std::string(StringPool::str(name)));
   }
-  else
+  return symbols[id];
+}
+
+const Symbol &SymbolTable::getSymbol(Atom name) const
+{
+  SymbolId id = find(name);
+  if (id == NO_SYMBOL)
   {
-    // 如果符号不存在，则创建新的符号并设置段名称
-    symbols[name] = Symbol(name);
-    symbols[name].setSectionName(sectionName);
+    throw std::runtime_error("Symbol not found: " + std::string(StringPool::str(name)));
   }
+  return symbols[id];
 }
 
-void SymbolTable::setSegmentName(const std::string &name, const std::string &segmentName)
+Symbol &SymbolTable::getSymbol(std::string_view name)
 {
-  auto it = symbols.find(name);
-  if (it != symbols.end())
+  Atom atom;
+  if (!StringPool::find(name, atom))
   {
-    it->second.setSegmentName(segmentName);
+    throw std::runtime_error("Symbol not found: " + std::string(name));
   }
-  else
+  return getSymbol(atom);
+}
+
+const Symbol &SymbolTable::getSymbol(std::string_view name) const
+{
+  Atom atom;
+  if (!StringPool::find(name, atom))
   {
-    // 如果符号不存在，则创建新的符号并设置段名称
-    symbols[name] = Symbol(name);
-    symbols[name].setSegmentName(segmentName);
+    throw std::runtime_error("Symbol not found: " + std::string(name));
   }
+  return getSymbol(atom);
 }
 
-std::string SymbolTable::getSectionName(const std::string &symbolName) const
+void SymbolTable::updateSymbolAddress(Atom name, uint32_t saddress, uint32_t gaddress, uint32_t inSecAddress)
 {
-  auto it = symbols.find(symbolName);
-  if (it != symbols.end())
+  SymbolId id = find(name);
+  if (id != NO_SYMBOL)
   {
-    return it->second.getSectionName();
+    symbols[id].setInSecAddress(inSecAddress);
   }
   else
   {
-    throw std::runtime_error("Symbol not found: " + symbolName);
+    // 如果符号不存在，则创建新的符号并设置地址（与原来一样不设置段内地址）
+    id = intern(name);
   }
+  symbols[id].setSAddress(saddress);
+  symbols[id].setGAddress(gaddress);
+}
+
+void SymbolTable::setGlobal(Atom name, bool isGlobal)
+{
+  symbols[intern(name)].setGlobal(isGlobal);
+}
+
+void SymbolTable::setType(Atom name, SymbolType type)
+{
+  symbols[intern(name)].setType(type);
+}
+
+void SymbolTable::setSize(Atom name, int size)
+{
+  sizes[intern(name)] = size;
+}
+
+void SymbolTable::setSectionName(Atom name, Atom sectionName)
+{
+  symbols[intern(name)].setSectionName(sectionName);
+}
+
+void SymbolTable::setSegmentName(Atom name, Atom segmentName)
+{
+  symbols[intern(name)].setSegmentName(segmentName);
 }
 
-std::unordered_map<std::string, Symbol> &SymbolTable::getSymbols()
+std::string_view SymbolTable::getSectionName(Atom symbolName) const
 {
-  return symbols;
+  return getSymbol(symbolName).getSectionName();
 }
-void setSegmentName(const std::string &segmentName);
\ No newline at end of file
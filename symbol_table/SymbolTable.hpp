@@ -69,11 +69,13 @@
 #define SYMBOL_TABLE_HPP
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 #include <cstdint>
+#include "../utils/StringPool.hpp"
 
 // 符号的类型
-enum class SymbolType
+enum class SymbolType : uint8_t
 {
   LABEL,
   FUNCTION,
@@ -81,28 +83,26 @@ enum class SymbolType
   UNDEFINED
 };
 
-// 符号类
+// 符号句柄：符号在表中的下标，按首次出现的顺序分配，符号表存在期间一直有效
+using SymbolId = uint32_t;
+
+// 符号的常用字段（地址、所在节、类型、标志），汇编过程中反复读写；
+// 名字和大小很少用到，单独存放在 SymbolTable 中（见 getName / getSymbolSize）
 class Symbol
 {
 public:
   Symbol();
-  Symbol(const std::string &name,
-         uint32_t saddress = 0,
-         uint32_t gaddress = 0,
-         SymbolType type = SymbolType::UNDEFINED,
-         bool isGlobal = false,
-         int size = 0,
-         const std::string &sectionName = "");
+  Symbol(uint32_t saddress, uint32_t gaddress, SymbolType type, bool isGlobal, Atom sectionName);
 
   // Getter 方法
-  const std::string &getName() const;
   uint32_t getSAddress() const;
   uint32_t getGAddress() const;
   SymbolType getType() const;
   bool isGlobal() const;
-  int getSize() const;
-  const std::string &getSectionName() const;
-  const std::string &getSegmentName() const;
+  std::string_view getSectionName() const;
+  Atom getSectionId() const;
+  std::string_view getSegmentName() const;
+  Atom getSegmentId() const;
   uint32_t getInSecAddress() const;
 
   // Setter 方法
@@ -110,68 +110,131 @@ public:
   void setGAddress(uint32_t address);
   void setType(SymbolType type);
   void setGlobal(bool isGlobal);
-  void setSize(int size);
-  void setSectionName(const std::string &sectionName);
-  void setSegmentName(const std::string &segmentName);
+  void setSectionName(Atom sectionName);
+  void setSegmentName(Atom segmentName);
   void setInSecAddress(uint32_t inSecAddress);
 
+  // 只被重定位项引用过、源文件中没有出现（外部符号），见 SymbolTable::reference
+  bool isReferenceOnly() const { return referenceOnly; }
+
 private:
-  std::string name;          // 符号名称
+  friend class SymbolTable;
+
   uint32_t saddress = 0;     // 符号地址（段内地址）
   uint32_t gaddress = 0;     // 全局符号地址，用于计算 size
   uint32_t inSecAddress = 0; // 段内地址
-  SymbolType type;           // 符号类型
-  bool globalFlag;           // 是否为全局符号
-  int size = 0;              // 符号大小
-  std::string sectionName;   // 符号所在段的名称
-  std::string segmentName;   // 符号所在节的名称
+  Atom sectionName = 0;      // 符号所在段的名称
+  Atom segmentName = 0;      // 符号所在节的名称
+  SymbolType type = SymbolType::UNDEFINED; // 符号类型
+  bool globalFlag = false;   // 是否为全局符号
+  bool referenceOnly = false;
 };
 
+// 符号表：符号按首次出现的顺序连续存放，以 SymbolId 访问；
+// 名字 -> 句柄用开放寻址的散列表（线性探测），键为驻留后的 Atom，不再对字符串求哈希。
+// 注意添加符号后之前取得的 Symbol 引用可能失效，需要长期保存时用 SymbolId
 class SymbolTable
 {
 public:
-  SymbolTable();
+  static constexpr SymbolId NO_SYMBOL = UINT32_MAX;
 
-  // 添加符号到符号表
-  void addSymbol(const std::string &name,
-                 uint32_t saddress = 0,
-                 uint32_t gaddress = 0,
-                 SymbolType type = SymbolType::UNDEFINED,
-                 bool isGlobal = false,
-                 const std::string &sectionName = "");
-
-  // 检查符号是否存在
-  bool hasSymbol(const std::string &name) const;
-
-  // 获取符号信息
-  Symbol &getSymbol(const std::string &name);
-  const Symbol &getSymbol(const std::string &name) const;
+  SymbolTable();
 
+  // 查找符号的句柄，不存在（或只被重定位项引用过）时返回 NO_SYMBOL
+  SymbolId find(Atom name) const;
+
+  // 查找符号的句柄，包括只被重定位项引用过的符号，不存在时返回 NO_SYMBOL
+  SymbolId lookup(Atom name) const;
+
+  // 查找符号的句柄，不存在时创建一个未定义的符号
+  SymbolId intern(Atom name);
+
+  // 重定位项引用的符号的句柄：不存在时创建一个只被引用的外部符号。
+  // 这种符号在 find / hasSymbol / findSymbol 看来仍不存在，源文件之后声明或定义它时按新符号处理；
+  // 它们同样占用句柄，写 ELF 时作为未定义符号输出
+  SymbolId reference(Atom name);
+
+  // 按句柄访问
+  Symbol &operator[](SymbolId id) { return symbols[id]; }
+  const Symbol &operator[](SymbolId id) const { return symbols[id]; }
+  Atom getName(SymbolId id) const { return names[id]; }
+  int getSymbolSize(SymbolId id) const { return sizes[id]; }
+  void setSymbolSize(SymbolId id, int size) { sizes[id] = size; }
+
+  // 符号个数；句柄为 0 到 size() - 1
+  size_t size() const { return symbols.size(); }
+
+  // 删除所有符号，之前的句柄全部失效；容量留着复用，远大于删掉的符号个数时释放
+  void clear();
+
+  // 添加符号到符号表（已存在时只更新提供的属性），返回其句柄
+  SymbolId addSymbol(Atom name,
+                     uint32_t saddress = 0,
+                     uint32_t gaddress = 0,
+                     SymbolType type = SymbolType::UNDEFINED,
+                     bool isGlobal = false,
+                     Atom sectionName = 0);
+  SymbolId addSymbol(std::string_view name,
+                     uint32_t saddress = 0,
+                     uint32_t gaddress = 0,
+                     SymbolType type = SymbolType::UNDEFINED,
+                     bool isGlobal = false,
+                     std::string_view sectionName = "");
+
+  // 检查符号是否存在（按名字查询时不会驻留新字符串）
+  bool hasSymbol(Atom name) const;
+  bool hasSymbol(std::string_view name) const;
+
+  // 查找符号，不存在时返回 nullptr
+  const Symbol *findSymbol(Atom name) const;
+
+  // 获取符号信息，不存在时抛出异常
+  Symbol &getSymbol(Atom name);
+  const Symbol &getSymbol(Atom name) const;
+  Symbol &getSymbol(std::string_view name);
+  const Symbol &getSymbol(std::string_view name) const;
+
+  // 以下按名字修改的函数在符号不存在时都会先创建符号
   // 更新符号的地址
-  void updateSymbolAddress(const std::string &name, uint32_t saddress, uint32_t gaddress, uint32_t inSecAddress);
+  void updateSymbolAddress(Atom name, uint32_t saddress, uint32_t gaddress, uint32_t inSecAddress);
 
   // 设置符号为全局
-  void setGlobal(const std::string &name, bool isGlobal);
+  void setGlobal(Atom name, bool isGlobal);
 
   // 设置符号的类型
-  void setType(const std::string &name, SymbolType type);
+  void setType(Atom name, SymbolType type);
 
   // 设置符号的大小
-  void setSize(const std::string &name, int size);
+  void setSize(Atom name, int size);
 
   // 设置符号的段名称
-  void setSectionName(const std::string &name, const std::string &sectionName);
+  void setSectionName(Atom name, Atom sectionName);
 
-  void setSegmentName(const std::string &name, const std::string &segmentName);
+  void setSegmentName(Atom name, Atom segmentName);
 
   // 获取符号的段名称
-  std::string getSectionName(const std::string &symbolName) const;
-
-  // 获取所有符号
-  std::unordered_map<std::string, Symbol> &getSymbols();
+  std::string_view getSectionName(Atom symbolName) const;
 
 private:
-  std::unordered_map<std::string, Symbol> symbols;
+  // 散列表的一格：id 为 NO_SYMBOL 表示空
+  struct Slot
+  {
+    Atom name;
+    SymbolId id;
+  };
+
+  // 名字在散列表中的起始位置（Fibonacci 散列，取乘积的高位）
+  size_t home(Atom name) const { return static_cast<uint32_t>(name * 0x9E3779B1u) >> shift; }
+  SymbolId create(Atom name);
+  void grow();
+
+  static constexpr size_t INITIAL_SLOTS = 64;
+
+  std::vector<Symbol> symbols; // 常用字段，按句柄连续存放
+  std::vector<Atom> names;     // 名字，与 symbols 一一对应
+  std::vector<int> sizes;      // 大小（.size），与 symbols 一一对应
+  std::vector<Slot> slots;     // 容量为 2 的幂，装填率不超过 1/2
+  uint32_t shift = 32;         // 32 - log2(slots.size())
 };
 
 #endif // SYMBOL_TABLE_HPP
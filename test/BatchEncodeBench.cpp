@@ -0,0 +1,135 @@
+// test/BatchEncodeBench.cpp
+// 批量编码的微基准：逐条 Instruction::encode 与 BatchEncoder 的标量 / AVX2 版本对比（ns/条）。
+// 输入为随机生成的直线程序（各格式混合，含 B/J 型偏移），三种方式的结果必须一致
+// 用法：batch_encode_bench [指令条数] [轮数]
+
+#include "../instruction/BatchEncoder.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+  size_t count = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 20;
+
+  // 随机生成可批量编码的指令（跳过伪指令）
+  std::mt19937 rng(12345);
+  std::vector<Opcode> opcodes;
+  for (size_t i = 0; i < OpcodeTable::COUNT; i++)
+  {
+    if (OpcodeTable::entries[i].format != Format::P)
+    {
+      opcodes.push_back(static_cast<Opcode>(i));
+    }
+  }
+  auto randomImmediate = [&](ImmKind kind) -> int32_t
+  {
+    switch (kind)
+    {
+    case ImmKind::I12:
+    case ImmKind::S12:
+      return static_cast<int32_t>(rng() % 4096) - 2048;
+    case ImmKind::B13:
+      return (static_cast<int32_t>(rng() % 8192) - 4096) * 2;
+    case ImmKind::U20:
+      return static_cast<int32_t>(rng() % (1 << 20));
+    case ImmKind::J21:
+      return (static_cast<int32_t>(rng() % (1 << 19)) - (1 << 18)) * 4;
+    default:
+      return 0;
+    }
+  };
+
+  std::vector<Instruction> instructions(count);
+  InstructionBatch batch;
+  for (Instruction &instruction : instructions)
+  {
+    instruction.op = opcodes[rng() % opcodes.size()];
+    instruction.rd = rng() % 32;
+    instruction.rs1 = rng() % 32;
+    instruction.rs2 = rng() % 32;
+    instruction.imm = randomImmediate(OpcodeTable::info(instruction.op).immKind);
+    if (!BatchEncoder::accepts(instruction))
+    {
+      std::cerr << "生成了不能批量编码的指令：" << instruction.mnemonic() << std::endl;
+      return 1;
+    }
+    batch.push(instruction);
+  }
+
+  // 逐条编码：B/J 型引用一个固定地址的标签，由当前地址得到所需的偏移，编码完后统一回填
+  SymbolTable symbolTable;
+  RelocationTable relocationTable;
+  FixupList fixups;
+  const uint32_t labelAddress = 0x40000000;
+  Atom label = StringPool::intern("bench_target");
+  symbolTable.addSymbol(label, labelAddress, labelAddress, SymbolType::LABEL);
+
+  std::vector<uint32_t> expected(count);
+  std::vector<uint32_t> scalar(count);
+  std::vector<uint32_t> vectorized(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    Instruction instruction = instructions[i];
+    uint32_t currentAddress = 0;
+    Format format = OpcodeTable::info(instruction.op).format;
+    if (format == Format::B || format == Format::J)
+    {
+      instruction.symbol = label;
+      currentAddress = labelAddress - static_cast<uint32_t>(instruction.imm);
+    }
+    fixups.setBase(static_cast<uint32_t>(i * 4));
+    instruction.encode(currentAddress, &expected[i], fixups);
+  }
+
+  fixups.resolve(symbolTable, relocationTable, 0, [&expected](uint32_t offset, uint32_t bits)
+                 { expected[offset / 4] |= bits; });
+
+  // 计时的逐条编码只用不引用符号的指令，避免把符号表查找算进去
+  std::vector<Instruction> symbolFree;
+  for (const Instruction &instruction : instructions)
+  {
+    Format format = OpcodeTable::info(instruction.op).format;
+    if (format != Format::B && format != Format::J)
+    {
+      symbolFree.push_back(instruction);
+    }
+  }
+  std::vector<uint32_t> perInstruction(symbolFree.size());
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    for (size_t i = 0; i < symbolFree.size(); i++)
+    {
+      symbolFree[i].encode(0, &perInstruction[i], fixups);
+    }
+  }
+  double perInstructionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    BatchEncoder::encodeScalar(batch.op.data(), batch.rd.data(), batch.rs1.data(), batch.rs2.data(), batch.imm.data(), count, scalar.data());
+  }
+  double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    BatchEncoder::encode(batch, vectorized.data());
+  }
+  double vectorSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool same = scalar == expected && vectorized == expected;
+  double encoded = double(rounds) * count;
+  std::cout << count << " instructions x " << rounds << " rounds" << std::endl;
+  std::cout << "逐条 encode: " << perInstructionSeconds / (double(rounds) * symbolFree.size()) * 1e9 << " ns/条（不含 B/J）" << std::endl;
+  std::cout << "批量（标量）: " << scalarSeconds / encoded * 1e9 << " ns/条" << std::endl;
+  std::cout << "批量（" << (BatchEncoder::hasAVX2() ? "AVX2" : "标量") << "）: " << vectorSeconds / encoded * 1e9 << " ns/条"
+            << (same ? "" : " (与逐条编码的结果不一致!)") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+// test/EncodeBench.cpp
+// 编码阶段的微基准：统计每条指令的堆分配次数和耗时。
+// “旧接口”按原来的方式实现（每次编码返回一个 std::vector，节数据逐字节 push_back），
+// “新接口”编码到调用方的缓冲区后一次写入节数据
+// 用法：encode_bench [汇编文件] [轮数]
+
+#include "../instruction/Instruction.hpp"
+#include "../section/Section.hpp"
+#include "../lexer/Lexer.hpp"
+#include "../utils/LineScanner.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+  allocationCount++;
+  if (void *p = std::malloc(size ? size : 1))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+// 旧接口的形状：每条指令一个新分配的 vector
+static std::vector<uint32_t> encodeToVector(const Instruction &instruction, FixupList &fixups)
+{
+  uint32_t words[Instruction::MAX_ENCODED_WORDS];
+  size_t count = instruction.encode(0, words, fixups);
+  std::vector<uint32_t> result;
+  for (size_t i = 0; i < count; i++)
+  {
+    result.push_back(words[i]);
+  }
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "clang.s";
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 200;
+
+  std::ifstream infile(filename, std::ios::binary);
+  if (!infile)
+  {
+    std::cerr << "无法打开文件 " << filename << std::endl;
+    return 1;
+  }
+  std::ostringstream oss;
+  oss << infile.rdbuf();
+  std::string text = oss.str();
+
+  TokenArena arena;
+  std::vector<std::string_view> lines;
+  LineScanner::split(text, lines);
+  arena.reset(text.data());
+  Lexer::lex(lines, arena);
+
+  // 解码全部指令；引用到的符号都定义在地址 0，回填时不会产生重定位项
+  SymbolTable symbolTable;
+  RelocationTable relocationTable;
+  FixupList fixups;
+  std::vector<Instruction> instructions;
+  for (const LexedLine &lexed : arena.getLines())
+  {
+    if (lexed.kind != LineKind::Instruction || lexed.tokenCount == 0)
+    {
+      continue;
+    }
+    try
+    {
+      Instruction instruction = Instruction::decode(arena, lexed);
+      if (instruction.symbol != 0)
+      {
+        symbolTable.addSymbol(instruction.symbol, 0, 0, SymbolType::LABEL);
+      }
+      uint32_t words[Instruction::MAX_ENCODED_WORDS];
+      instruction.encode(0, words, fixups);
+      fixups.resolve(symbolTable, relocationTable, 0, [](uint32_t, uint32_t) {});
+      instructions.push_back(instruction);
+    }
+    catch (const std::exception &)
+    {
+      // 这里只测能编码的指令
+      fixups.clear();
+    }
+  }
+  if (instructions.empty())
+  {
+    std::cerr << "没有可编码的指令：" << filename << std::endl;
+    return 1;
+  }
+
+  size_t encoded = rounds * instructions.size();
+  std::vector<uint8_t> legacyBytes;
+  Section section;
+
+  // 旧接口
+  size_t before = allocationCount;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    legacyBytes.clear();
+    fixups.clear();
+    for (const Instruction &instruction : instructions)
+    {
+      std::vector<uint32_t> machineCode = encodeToVector(instruction, fixups);
+      for (uint32_t word : machineCode)
+      {
+        legacyBytes.push_back(word & 0xFF);
+        legacyBytes.push_back((word >> 8) & 0xFF);
+        legacyBytes.push_back((word >> 16) & 0xFF);
+        legacyBytes.push_back((word >> 24) & 0xFF);
+      }
+    }
+  }
+  double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t legacyAllocations = allocationCount - before;
+
+  // 新接口：每轮新建节，节数据扩容的分配也计入（符号都在地址 0，回填不改变机器码，这里只清空修补记录）
+  before = allocationCount;
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    section = Section();
+    for (const Instruction &instruction : instructions)
+    {
+      uint32_t machineCode[Instruction::MAX_ENCODED_WORDS];
+      fixups.setBase(static_cast<uint32_t>(section.getData().size()));
+      size_t count = instruction.encode(0, machineCode, fixups);
+      section.addInstruction(machineCode, count);
+    }
+    fixups.clear();
+  }
+  double spanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t spanAllocations = allocationCount - before;
+
+  bool same = section.getData() == legacyBytes;
+  std::cout << instructions.size() << " instructions x " << rounds << " rounds" << std::endl;
+  std::cout << "旧接口: " << double(legacyAllocations) / encoded << " 次分配/条, "
+            << legacySeconds / encoded * 1e9 << " ns/条" << std::endl;
+  std::cout << "新接口: " << double(spanAllocations) / encoded << " 次分配/条, "
+            << spanSeconds / encoded * 1e9 << " ns/条" << (same ? "" : " (与旧接口结果不一致!)") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+// test/LexerBench.cpp
+// 并行分词的扩展性测试：线程数从 1 到 16，输出耗时、吞吐量和相对单线程的加速比
+// 用法：lexer_bench [汇编文件] [目标大小MB] [最大线程数]
+
+#include "../lexer/Lexer.hpp"
+#include "../utils/LineScanner.hpp"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 两个 arena 的行和词法单元是否完全一致
+static bool sameTokens(const TokenArena &a, const TokenArena &b)
+{
+  const std::vector<LexedLine> &la = a.getLines();
+  const std::vector<LexedLine> &lb = b.getLines();
+  if (la.size() != lb.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < la.size(); i++)
+  {
+    if (la[i].kind != lb[i].kind || la[i].offset != lb[i].offset || la[i].length != lb[i].length ||
+        la[i].firstToken != lb[i].firstToken || la[i].tokenCount != lb[i].tokenCount)
+    {
+      return false;
+    }
+    const Token *ta = a.begin(la[i]);
+    const Token *tb = b.begin(lb[i]);
+    for (uint32_t j = 0; j < la[i].tokenCount; j++)
+    {
+      if (ta[j].kind != tb[j].kind || ta[j].offset != tb[j].offset || ta[j].length != tb[j].length || ta[j].value != tb[j].value)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "clang.s";
+  size_t targetSize = (argc > 2 ? std::stoul(argv[2]) : 256) << 20;
+  unsigned maxThreads = argc > 3 ? std::stoul(argv[3]) : 16;
+
+  std::ifstream infile(filename, std::ios::binary);
+  if (!infile)
+  {
+    std::cerr << "无法打开文件 " << filename << std::endl;
+    return 1;
+  }
+  std::ostringstream oss;
+  oss << infile.rdbuf();
+  std::string unit = oss.str();
+  if (unit.empty())
+  {
+    std::cerr << "文件为空：" << filename << std::endl;
+    return 1;
+  }
+
+  std::string text;
+  text.reserve(targetSize + unit.size());
+  while (text.size() < targetSize)
+  {
+    text += unit;
+  }
+
+  // 串行结果作为参照
+  TokenArena reference;
+  {
+    std::vector<std::string_view> lines;
+    LineScanner::split(text, lines);
+    reference.reset(text.data());
+    Lexer::lex(lines, reference);
+  }
+
+  double single = 0;
+  std::cout << "input " << text.size() / (1 << 20) << " MB, " << reference.getLines().size() << " lines" << std::endl;
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    double best = 1e30;
+    bool same = true;
+    for (int round = 0; round < 3; round++)
+    {
+      TokenArena arena;
+      arena.reset(text.data());
+      auto start = std::chrono::steady_clock::now();
+      Lexer::lexParallel(text, arena, threads);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      best = std::min(best, seconds);
+      same = same && sameTokens(arena, reference);
+    }
+    if (threads == 1)
+    {
+      single = best;
+    }
+    std::cout << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(3) << best << " s, "
+              << text.size() / best / 1e6 << " MB/s, speedup " << single / best << "x"
+              << (same ? "" : " (与串行结果不一致!)") << std::endl;
+    if (!same)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+// test/LineScannerBench.cpp
+// 行切分阶段的微基准：分别测试 scalar / SSE2 / AVX2 的吞吐量（GB/s）
+// 用法：line_scanner_bench [汇编文件] [目标大小MB]
+
+#include "../utils/LineScanner.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "clang.s";
+  size_t targetSize = (argc > 2 ? std::stoul(argv[2]) : 64) << 20;
+
+  std::ifstream infile(filename, std::ios::binary);
+  if (!infile)
+  {
+    std::cerr << "无法打开文件 " << filename << std::endl;
+    return 1;
+  }
+  std::ostringstream oss;
+  oss << infile.rdbuf();
+  std::string unit = oss.str();
+  if (unit.empty())
+  {
+    std::cerr << "文件为空：" << filename << std::endl;
+    return 1;
+  }
+
+  // 重复拼接到目标大小，避免测到的是缓存内的小文件
+  std::string text;
+  text.reserve(targetSize + unit.size());
+  while (text.size() < targetSize)
+  {
+    text += unit;
+  }
+
+  std::vector<std::string_view> reference;
+  LineScanner::split(text, reference, LineScanner::Isa::Scalar);
+
+  const LineScanner::Isa isas[] = {LineScanner::Isa::Scalar, LineScanner::Isa::SSE2, LineScanner::Isa::AVX2};
+  for (LineScanner::Isa isa : isas)
+  {
+    if (isa == LineScanner::Isa::AVX2 && LineScanner::detect() != LineScanner::Isa::AVX2)
+    {
+      continue;
+    }
+    std::vector<std::string_view> lines;
+    lines.reserve(reference.size());
+    double best = 1e30;
+    for (int round = 0; round < 5; round++)
+    {
+      lines.clear();
+      auto start = std::chrono::steady_clock::now();
+      LineScanner::split(text, lines, isa);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      best = std::min(best, seconds);
+    }
+    bool same = lines == reference;
+    std::cout << LineScanner::isaName(isa) << ": " << text.size() / best / 1e9 << " GB/s, "
+              << lines.size() << " lines" << (same ? "" : " (与 scalar 结果不一致!)") << std::endl;
+    if (!same)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
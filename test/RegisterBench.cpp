@@ -0,0 +1,80 @@
+// test/RegisterBench.cpp
+// 寄存器名查找的微基准：原来的 unordered_map<std::string> 与 RegisterTable 对比（ns/次）。
+// 输入为全部寄存器名加上同样数量的非寄存器标识符（词法分析对每个标识符都会查一次）
+// 用法：register_bench [轮数]
+
+#include "../utils/RegisterTable.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+  size_t rounds = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+  // 原实现：每次查找先构造 std::string，再查散列表
+  std::unordered_map<std::string, uint32_t> regMap;
+  for (const RegisterTable::Entry &entry : RegisterTable::entries)
+  {
+    regMap.emplace(std::string(entry.name), entry.number);
+  }
+
+  std::vector<std::string_view> names;
+  for (const RegisterTable::Entry &entry : RegisterTable::entries)
+  {
+    names.push_back(entry.name);
+  }
+  const std::string_view others[] = {"main", "loop", "x32", "s12", "a8", "zer", "fpx", "t", ".L1", "sum",
+                                     "printf", "buf", "tmp", "end", "len", "i", "str", "ptr", "val", "cnt"};
+  size_t registerCount = names.size();
+  while (names.size() < 2 * registerCount)
+  {
+    names.push_back(others[names.size() % (sizeof(others) / sizeof(others[0]))]);
+  }
+
+  // 两种实现的结果必须一致
+  for (std::string_view name : names)
+  {
+    uint32_t number = 0;
+    bool found = RegisterTable::lookup(name, number);
+    auto it = regMap.find(std::string(name));
+    if (found != (it != regMap.end()) || (found && number != it->second))
+    {
+      std::cerr << "结果不一致：" << name << std::endl;
+      return 1;
+    }
+  }
+
+  size_t lookups = rounds * names.size();
+  uint64_t checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    for (std::string_view name : names)
+    {
+      auto it = regMap.find(std::string(name));
+      checksum += it != regMap.end() ? it->second : 1;
+    }
+  }
+  double mapSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    for (std::string_view name : names)
+    {
+      uint32_t number;
+      checksum += RegisterTable::lookup(name, number) ? number : 1;
+    }
+  }
+  double tableSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "unordered_map: " << mapSeconds / lookups * 1e9 << " ns/次" << std::endl;
+  std::cout << "RegisterTable: " << tableSeconds / lookups * 1e9 << " ns/次" << std::endl;
+  std::cout << "加速比: " << mapSeconds / tableSeconds << "x (checksum " << checksum << ")" << std::endl;
+  return 0;
+}
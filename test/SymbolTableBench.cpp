@@ -0,0 +1,159 @@
+// test/SymbolTableBench.cpp
+// 符号表的微基准：按原来的方式（std::unordered_map<Atom, 符号>）与开放寻址的 SymbolTable 对比
+// 添加标签、按名字查找（命中 / 不命中）和按句柄访问的耗时（ns/次），以及堆分配次数
+// 用法：symbol_table_bench [标签个数] [轮数]
+
+#include "../symbol_table/SymbolTable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+  allocationCount++;
+  if (void *p = std::malloc(size ? size : 1))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  std::free(p);
+}
+
+// 原来的符号：名字、大小与地址放在一起，每个符号一个散列表节点
+struct MapSymbol
+{
+  Atom name;
+  uint32_t saddress;
+  uint32_t gaddress;
+  uint32_t inSecAddress;
+  SymbolType type;
+  bool globalFlag;
+  int size;
+  Atom sectionName;
+  Atom segmentName;
+};
+
+template <typename F>
+static double nanosecondsPer(size_t operations, size_t rounds, F &&body)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; round++)
+  {
+    body();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return seconds / (double(operations) * rounds) * 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  // 标签名先驻留好，两种实现都以 Atom 为键；查找按随机顺序进行
+  std::vector<Atom> labels(count);
+  std::vector<Atom> missing(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    labels[i] = StringPool::intern(".LBB" + std::to_string(i));
+    missing[i] = StringPool::intern("undefined_" + std::to_string(i));
+  }
+  std::vector<Atom> shuffled = labels;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(12345));
+  Atom section = StringPool::intern(".text");
+
+  uint64_t checksum = 0;
+  size_t before = allocationCount;
+  double mapInsert = nanosecondsPer(count, rounds, [&]
+                                    {
+    std::unordered_map<Atom, MapSymbol> map;
+    for (size_t i = 0; i < count; i++)
+    {
+      map[labels[i]] = MapSymbol{labels[i], uint32_t(i * 4), uint32_t(i * 4), 0, SymbolType::LABEL, false, 0, section, 0};
+    }
+    checksum += map.size(); });
+  double mapAllocations = double(allocationCount - before) / (double(count) * rounds);
+
+  before = allocationCount;
+  double tableInsert = nanosecondsPer(count, rounds, [&]
+                                      {
+    SymbolTable table;
+    for (size_t i = 0; i < count; i++)
+    {
+      table.addSymbol(labels[i], uint32_t(i * 4), uint32_t(i * 4), SymbolType::LABEL, false, section);
+    }
+    checksum += table.size(); });
+  double tableAllocations = double(allocationCount - before) / (double(count) * rounds);
+
+  std::unordered_map<Atom, MapSymbol> map;
+  SymbolTable table;
+  std::vector<SymbolId> ids(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    map[labels[i]] = MapSymbol{labels[i], uint32_t(i * 4), uint32_t(i * 4), 0, SymbolType::LABEL, false, 0, section, 0};
+    ids[i] = table.addSymbol(labels[i], uint32_t(i * 4), uint32_t(i * 4), SymbolType::LABEL, false, section);
+  }
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(54321));
+
+  double mapHit = nanosecondsPer(count, rounds, [&]
+                                 {
+    for (Atom label : shuffled)
+    {
+      checksum += map.find(label)->second.gaddress;
+    } });
+  double tableHit = nanosecondsPer(count, rounds, [&]
+                                   {
+    for (Atom label : shuffled)
+    {
+      checksum += table.findSymbol(label)->getGAddress();
+    } });
+  double mapMiss = nanosecondsPer(count, rounds, [&]
+                                  {
+    for (Atom name : missing)
+    {
+      checksum += map.find(name) == map.end();
+    } });
+  double tableMiss = nanosecondsPer(count, rounds, [&]
+                                    {
+    for (Atom name : missing)
+    {
+      checksum += table.findSymbol(name) == nullptr;
+    } });
+  double handle = nanosecondsPer(count, rounds, [&]
+                                 {
+    for (SymbolId id : ids)
+    {
+      checksum += table[id].getGAddress();
+    } });
+
+  bool same = true;
+  for (size_t i = 0; i < count; i++)
+  {
+    same = same && table.findSymbol(labels[i])->getGAddress() == map[labels[i]].gaddress && table.getName(table.find(labels[i])) == labels[i];
+  }
+
+  std::cout << count << " labels x " << rounds << " rounds (checksum " << checksum << ")" << std::endl;
+  std::cout << "添加:   unordered_map " << mapInsert << " ns（" << mapAllocations << " 次分配/个）, SymbolTable " << tableInsert
+            << " ns（" << tableAllocations << " 次分配/个）" << std::endl;
+  std::cout << "命中:   unordered_map " << mapHit << " ns, SymbolTable " << tableHit << " ns" << std::endl;
+  std::cout << "不命中: unordered_map " << mapMiss << " ns, SymbolTable " << tableMiss << " ns" << std::endl;
+  std::cout << "按句柄: " << handle << " ns" << (same ? "" : " (查找结果不一致!)") << std::endl;
+  return same ? 0 : 1;
+}
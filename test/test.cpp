@@ -0,0 +1,382 @@
+// test/test.cpp
+// 回归测试：把小段汇编写进临时文件，用 Assembler 汇编后逐字比较机器码或错误信息
+// 用法：make test（全部通过时返回 0）
+
+#include "../trunk/Assembler.hpp"
+#include "../lexer/IncludeCache.hpp"
+#include "../utils/LineScanner.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+  int failures = 0;
+  int checks = 0;
+
+  enum class Mode
+  {
+    OnePass,
+    TwoPass,
+    Stream
+  };
+
+  const char *modeName(Mode mode)
+  {
+    switch (mode)
+    {
+    case Mode::TwoPass:
+      return "--two-pass";
+    case Mode::Stream:
+      return "--stream";
+    default:
+      return "一遍扫描";
+    }
+  }
+
+  std::string tempPath(const char *suffix)
+  {
+    return "/tmp/assembler_test_" + std::to_string(getpid()) + suffix;
+  }
+
+  // 汇编 source，返回输出的机器码（按小端序读回）；出错时抛出异常。symbolCount 不为空时存入符号表中的符号个数
+  std::vector<uint32_t> assembleText(const std::string &source, Mode mode = Mode::OnePass, size_t *symbolCount = nullptr)
+  {
+    std::string input = tempPath(".s");
+    std::string output = tempPath(".bin");
+    std::ofstream(input, std::ios::binary) << source;
+    std::remove(output.c_str());
+
+    // 结果信息写到标准输出，测试时关掉
+    std::streambuf *saved = std::cout.rdbuf(nullptr);
+    try
+    {
+      Assembler assembler;
+      if (mode == Mode::Stream)
+      {
+        assembler.assembleStream(input, output);
+      }
+      else
+      {
+        assembler.setTwoPass(mode == Mode::TwoPass);
+        assembler.assemble(input, output, false);
+      }
+      if (symbolCount)
+      {
+        *symbolCount = assembler.getSymbolCount();
+      }
+    }
+    catch (...)
+    {
+      std::cout.rdbuf(saved);
+      std::remove(input.c_str());
+      throw;
+    }
+    std::cout.rdbuf(saved);
+
+    std::ifstream in(output, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<uint32_t> words(bytes.size() / 4);
+    for (size_t i = 0; i < words.size(); i++)
+    {
+      const unsigned char *p = reinterpret_cast<const unsigned char *>(bytes.data()) + i * 4;
+      words[i] = p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+    return words;
+  }
+
+  void check(bool ok, const std::string &what)
+  {
+    checks++;
+    if (!ok)
+    {
+      failures++;
+      std::cerr << "失败：" << what << std::endl;
+    }
+  }
+
+  // 各模式下都汇编成功，且机器码为 expected
+  void expectWords(const std::string &name, const std::string &source, const std::vector<uint32_t> &expected,
+                   std::initializer_list<Mode> modes = {Mode::OnePass, Mode::TwoPass, Mode::Stream})
+  {
+    for (Mode mode : modes)
+    {
+      std::string what = name + "（" + modeName(mode) + "）";
+      try
+      {
+        check(assembleText(source, mode) == expected, what + "：机器码不符");
+      }
+      catch (const std::exception &e)
+      {
+        check(false, what + "：" + e.what());
+      }
+    }
+  }
+
+  // 各模式下都报错，且错误信息包含 message
+  void expectError(const std::string &name, const std::string &source, const std::string &message,
+                   std::initializer_list<Mode> modes = {Mode::OnePass, Mode::TwoPass, Mode::Stream})
+  {
+    for (Mode mode : modes)
+    {
+      std::string what = name + "（" + modeName(mode) + "）";
+      try
+      {
+        assembleText(source, mode);
+        check(false, what + "：没有报错");
+      }
+      catch (const std::exception &e)
+      {
+        check(std::string(e.what()).find(message) != std::string::npos, what + "：错误信息为 " + e.what());
+      }
+    }
+  }
+
+  // 一遍扫描和流式汇编的结果与 --two-pass 相同
+  void expectSameAsTwoPass(const std::string &name, const std::string &source)
+  {
+    std::vector<uint32_t> expected;
+    try
+    {
+      expected = assembleText(source, Mode::TwoPass);
+    }
+    catch (const std::exception &e)
+    {
+      check(false, name + "（--two-pass）：" + e.what());
+      return;
+    }
+    check(!expected.empty(), name + "（--two-pass）：没有输出");
+    expectWords(name, source, expected, {Mode::OnePass, Mode::Stream});
+  }
+
+  // ---------------------------------------------------------------- .include
+
+  void testIncludeCacheReplacesChangedFile()
+  {
+    // 头文件改动后重新分词，缓存里仍只有它的一项；同一文件的不同写法共用一项
+    std::string header = tempPath("_inc.s");
+    std::string source = ".text\n.include \"" + header + "\"\n";
+    std::ofstream(header, std::ios::binary) << "addi a0, a0, 1\n";
+    size_t entries = IncludeCache::size();
+    try
+    {
+      check(assembleText(source) == std::vector<uint32_t>{0x00150513}, ".include：首次包含");
+      size_t hits = IncludeCache::getHits();
+      check(assembleText(".text\n.include \"/tmp/../" + header.substr(1) + "\"\n") == std::vector<uint32_t>{0x00150513},
+            ".include：同一文件的另一种写法");
+      check(IncludeCache::getHits() == hits + 1, ".include：未改动的文件应命中缓存");
+
+      std::ofstream(header, std::ios::binary | std::ios::trunc) << "addi a0, a0, 2\naddi a0, a0, 3\n";
+      check(assembleText(source) == std::vector<uint32_t>{0x00250513, 0x00350513}, ".include：改动后使用新内容");
+      check(IncludeCache::size() == entries + 1, ".include：改动后替换旧缓存项，缓存项个数为 " + std::to_string(IncludeCache::size()));
+    }
+    catch (const std::exception &e)
+    {
+      check(false, std::string(".include 缓存：") + e.what());
+    }
+    std::remove(header.c_str());
+  }
+
+  // ---------------------------------------------------------------- 宏
+
+  void testMacroRedefinition()
+  {
+    // A 重新定义后再定义 B：B 的编号不能与 A 的旧定义相同，否则共用展开缓存
+    expectWords("重新定义宏后定义另一个宏",
+                ".text\n"
+                ".macro A r\naddi \\r, \\r, 1\n.endm\n"
+                ".macro A r\naddi \\r, \\r, 2\n.endm\n"
+                ".macro B r\naddi \\r, \\r, 3\n.endm\n"
+                "A a0\nB a0\n",
+                {0x00250513, 0x00350513});
+  }
+
+  // ---------------------------------------------------------------- 伪指令参数
+
+  void testDirectiveIntegers()
+  {
+    // 伪指令的整数参数与指令的立即数用同一套语法：0x / 0b / 八进制 / 字符字面量
+    expectWords("伪指令参数的整数语法",
+                ".text\naddi a0, a0, 0x10\n"
+                ".type x,@object\n.p2align 0b10, 'a'\n.size x, 0x8\n",
+                {0x01050513});
+    expectError("伪指令参数超出 32 位", ".text\n.type x,@object\n.size x, 0x1ffffffff\n", "Immediate value out of range");
+    expectError("伪指令参数后有多余字符", ".text\n.type x,@object\n.p2align 2x\n", "Invalid immediate value: 2x");
+  }
+
+  // ---------------------------------------------------------------- 一遍扫描
+
+  void testOnePassMatchesTwoPass()
+  {
+    // 向前、向后的分支和跳转：向前引用挂在修补链上，标签定义时回填
+    expectSameAsTwoPass("向前和向后的分支",
+                        ".text\n"
+                        "start:\naddi a0, a0, 1\nbeq a0, zero, done\n"
+                        "loop:\naddi a0, a0, -1\nbne a0, zero, loop\njal ra, start\n"
+                        "blt a0, a1, done\njal ra, done\n"
+                        "done:\nret\n");
+
+    // %hi / %lo：lui 的高位和访存指令的低位，分别引用前面和后面的标签
+    expectSameAsTwoPass("%hi 和 %lo",
+                        ".text\n"
+                        "before:\nnop\n"
+                        "lui a0, %hi(before)\nlw a1, %lo(before)(a0)\n"
+                        "lui a0, %hi(after)\nlw a1, %lo(after)(a0)\n"
+                        ".p2align 4\n"
+                        "after:\nnop\n");
+
+    // .word 数据之后的标签地址：引用跨过 .word 的前后标签
+    expectSameAsTwoPass(".word 前后的标签",
+                        ".text\n"
+                        "jal ra, table_end\n"
+                        "table:\n.word 1 2 3\n"
+                        "table_end:\nlui a0, %hi(table)\nlw a1, %lo(table)(a0)\nbeq a0, zero, table_end\n"
+                        ".word 4\n"
+                        "jal ra, table\n");
+
+    // 重复定义标签在各模式下都报错
+    expectError("重复定义标签", ".text\nx:\nnop\nx:\nnop\n", "Symbol already defined: x");
+    expectError("重复定义函数内的 .L 标签",
+                ".text\n.type f,@function\nf:\n.LBB0_1:\nnop\n.LBB0_1:\nret\n",
+                "Symbol already defined: .LBB0_1");
+  }
+
+  // ---------------------------------------------------------------- 数字局部标签
+
+  void testNumericLocalLabels()
+  {
+    // Nb 取最近一次定义，Nf 取下一次定义；同一编号可以重复定义，最大编号为 65535
+    expectWords("数字局部标签",
+                ".text\n"
+                "1:\naddi a0, a0, -1\nbne a0, zero, 1b\n"
+                "beq a0, zero, 1f\njal ra, 1f\n"
+                "1:\nbne a0, zero, 1b\n"
+                "2:\njal ra, 2b\n"
+                "jal ra, 65535f\n65535:\nnop\n",
+                {0xfff50513, 0xfe051ee3, 0x00050463, 0x004000ef, 0x00051063, 0x000000ef, 0x004000ef, 0x00000013},
+                {Mode::OnePass, Mode::Stream});
+
+    expectError("数字局部标签编号超出范围", ".text\n65536:\nnop\n", "Local label number out of range: 65536",
+                {Mode::OnePass, Mode::Stream});
+    expectError("引用超出范围的数字局部标签", ".text\njal ra, 70000f\n", "Local label number out of range: 70000",
+                {Mode::OnePass, Mode::Stream});
+    expectError("向前引用的数字局部标签没有定义", ".text\njal ra, 3f\nnop\n", "Undefined local label: 3f",
+                {Mode::OnePass, Mode::Stream});
+    expectError("向后引用的数字局部标签没有定义", ".text\nnop\njal ra, 3b\n3:\nnop\n", "Undefined local label: 3b",
+                {Mode::OnePass, Mode::Stream});
+
+    // 两遍扫描不支持数字局部标签
+    expectError("两遍扫描中的数字局部标签", ".text\n1:\nnop\njal ra, 1b\n", "Numeric local labels require one-pass assembly",
+                {Mode::TwoPass});
+  }
+
+  // ---------------------------------------------------------------- .L 标签
+
+  void testScratchLabels()
+  {
+    // 函数外定义的 .L.str 被两个函数引用
+    expectSameAsTwoPass("函数外的 .L 标签被多个函数引用",
+                        ".section .rodata\n"
+                        ".L.str:\n"
+                        ".asciz \"hi\"\n"
+                        ".text\n"
+                        ".globl f\n.type f,@function\nf:\n"
+                        "lui a0, %hi(.L.str)\naddi a0, a0, %lo(.L.str)\nret\n"
+                        ".Lfunc_end0:\n.size f, .Lfunc_end0-f\n"
+                        ".globl g\n.type g,@function\ng:\n"
+                        "lui a0, %hi(.L.str)\naddi a0, a0, %lo(.L.str)\nret\n"
+                        ".Lfunc_end1:\n.size g, .Lfunc_end1-g\n");
+
+    // 函数内定义并设置了大小的 .L 标签（.size 记在临时表里），后面的函数仍可引用
+    expectSameAsTwoPass("函数内的 .L 标签被后面的函数引用",
+                        ".text\n"
+                        ".globl f\n.type f,@function\nf:\n"
+                        "addi a0, a0, 1\nret\n"
+                        ".type .Lk,@object\n.Lk:\n.word 5\n.size .Lk, 4\n"
+                        ".globl g\n.type g,@function\ng:\n"
+                        "lui a0, %hi(.Lk)\naddi a0, a0, %lo(.Lk)\nret\n"
+                        ".Lfunc_end1:\n.size g, .Lfunc_end1-g\n");
+  }
+
+  void testScratchLabelSymbolCount()
+  {
+    // 函数内的 .L 标签不进符号表：只剩 f、g 和函数外的 .L.str；后面的函数引用前面函数的 .L 标签时直接回填
+    std::string source = ".section .rodata\n.L.str:\n.asciz \"hi\"\n"
+                         ".text\n"
+                         ".globl f\n.type f,@function\nf:\n"
+                         "beq a0, zero, .LBB0_2\n.LBB0_1:\naddi a0, a0, -1\nbne a0, zero, .LBB0_1\n.LBB0_2:\nret\n"
+                         ".Lfunc_end0:\n.size f, .Lfunc_end0-f\n"
+                         ".globl g\n.type g,@function\ng:\n"
+                         "lui a0, %hi(.LBB0_2)\njal ra, .LBB0_1\nlui a1, %hi(.L.str)\n"
+                         "beq a0, zero, .LBB1_1\n.LBB1_1:\nret\n"
+                         ".Lfunc_end1:\n.size g, .Lfunc_end1-g\n";
+    expectSameAsTwoPass("函数内 .L 标签的回填", source);
+    for (Mode mode : {Mode::OnePass, Mode::Stream})
+    {
+      std::string what = std::string("符号表不含函数内的 .L 标签（") + modeName(mode) + "）";
+      try
+      {
+        size_t count = 0;
+        assembleText(source, mode, &count);
+        check(count == 3, what + "：符号个数为 " + std::to_string(count));
+      }
+      catch (const std::exception &e)
+      {
+        check(false, what + "：" + e.what());
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------- 行切分
+
+  void testCharLiteralComments()
+  {
+    // 字符字面量中的 '#' 不是注释，'"' 不开始字符串
+    expectWords("字符字面量中的 # 和 \"",
+                ".text\n"
+                "addi a0, a1, '#'\n"
+                "addi a0, a1, '\"'   # 注释中的 \" 和 #\n"
+                "addi a0, a1, '\\''  # 转义的单引号\n",
+                {0x02358513, 0x02258513, 0x02758513});
+
+    // 三种切分方式的结果一致（行足够长，SIMD 版本会处理整块）
+    std::string text = "  addi a0, a1, '#'            # 注释 \" 不影响下一行\n"
+                       "  addi a0, a1, '\"'  # 注释\n"
+                       "  .asciz \"a'#b\"   # 字符串中的单引号\n"
+                       "  addi a0, a1, '\\'' # x\n";
+    std::vector<std::string_view> expected{"addi a0, a1, '#'", "addi a0, a1, '\"'", ".asciz \"a'#b\"", "addi a0, a1, '\\''"};
+    for (LineScanner::Isa isa : {LineScanner::Isa::Scalar, LineScanner::Isa::SSE2, LineScanner::Isa::AVX2})
+    {
+      if (isa == LineScanner::Isa::AVX2 && LineScanner::detect() != LineScanner::Isa::AVX2)
+      {
+        continue;
+      }
+      std::vector<std::string_view> lines;
+      LineScanner::split(text, lines, isa);
+      check(lines == expected, std::string("LineScanner::split（") + LineScanner::isaName(isa) + "）：字符字面量");
+    }
+    check(LineScanner::cleanLine("addi a0, a1, '#' # x") == "addi a0, a1, '#'", "LineScanner::cleanLine：字符字面量中的 #");
+  }
+}
+
+int main()
+{
+  testIncludeCacheReplacesChangedFile();
+  testMacroRedefinition();
+  testDirectiveIntegers();
+  testOnePassMatchesTwoPass();
+  testNumericLocalLabels();
+  testScratchLabels();
+  testScratchLabelSymbolCount();
+  testCharLiteralComments();
+
+  std::cout << checks - failures << "/" << checks << " 项通过" << std::endl;
+  return failures == 0 ? 0 : 1;
+}
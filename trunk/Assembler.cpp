@@ -2,163 +2,858 @@
 
 #include "Assembler.hpp"
 #include <fstream>
-#include <sstream>
+#include <charconv>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
 #include "../utils/Utils.hpp"
+#include "../utils/LineScanner.hpp"
+#include "../utils/ArgCursor.hpp"
+#include "../utils/Trace.hpp"
+#include "../lexer/IncludeCache.hpp"
+
+namespace
+{
+  // 引用的是不是数字局部标签（1b、1f）：普通符号不以数字开头，只看一个字符就能排除
+  bool isLocalLabelReference(std::string_view name, uint32_t &number, bool &forward)
+  {
+    return !name.empty() && name[0] >= '0' && name[0] <= '9' && Utils::parseLocalLabelReference(name, number, forward);
+  }
+
+  // 编译器生成的局部标签（.L 开头），一遍扫描时放在函数的临时表里
+  bool isScratchLabel(std::string_view name)
+  {
+    return name.size() > 2 && name[0] == '.' && name[1] == 'L';
+  }
+}
 
 void Assembler::initializeSegments()
 {
-  segSecTable[".text"] = {};
-  segSecTable[".data"] = {};
-  segSecTable[".rodata"] = {};
-  segSecTable[".sdata"] = {};
-  segSecTable[".bss"] = {};
-  segAddressTable[".text"] = 0;
-  segAddressTable[".data"] = 0;
-  segAddressTable[".rodata"] = 0;
-  segAddressTable[".sdata"] = 0;
-  segAddressTable[".bss"] = 0;
-  baseAddressTable[".text"] = std::make_pair(0, 0);
-  baseAddressTable[".data"] = std::make_pair(0, 0);
-  baseAddressTable[".rodata"] = std::make_pair(0, 0);
-  baseAddressTable[".sdata"] = std::make_pair(0, 0);
-  baseAddressTable[".bss"] = std::make_pair(0, 0);
+  for (const char *segment : {".text", ".data", ".rodata", ".sdata", ".bss"})
+  {
+    Atom segmentName = StringPool::intern(segment);
+    segSecTable[segmentName] = {};
+    segAddressTable[segmentName] = 0;
+    baseAddressTable[segmentName] = std::make_pair(0, 0);
+  }
+}
+
+void Assembler::setTwoPass(bool twoPass)
+{
+  usingTwoPass = twoPass;
+}
+
+void Assembler::setLexThreads(unsigned threads)
+{
+  // 线程数不超过硬件线程数（查询不到时按 1 个处理）
+  unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+  lexThreads = std::min(std::max(1u, threads), hardware);
 }
 
 // 组装整个流程
 void Assembler::assemble(const std::string &inputFile, const std::string &outputFile, bool usingElfWriter)
 {
   isUsingElfWriter = usingElfWriter;
-  lines = readAssemblyCode(inputFile); // 读取文件中的汇编行
+  isOnePass = !usingElfWriter && !usingTwoPass; // ELF 模式仍按节两遍扫描
+  if (outputFile == "-")
+  {
+    log = &std::cerr; // 标准输出留给目标文件
+  }
+  if (lexThreads > 1)
+  {
+    // 并行模式：各线程自行切行并分词，不建立全局行索引；
+    // 地址分配仍由 firstPass 按顺序完成
+    if (!source.open(inputFile))
+    {
+      std::cerr << "无法打开文件 " << inputFile << " 进行读取。" << std::endl;
+    }
+    tokens.reset(source.getText().data());
+    Lexer::lexParallel(source.getText(), tokens, lexThreads);
+  }
+  else
+  {
+    std::vector<std::string_view> lines = readAssemblyCode(inputFile); // 读取文件中的汇编行
+    tokens.reset(source.getText().data());
+    Lexer::lex(lines, tokens); // 每个字节只分词一次，两遍扫描共用词法单元
+  }
+  TRACE(Lexer, Info, inputFile << "：分词完成，共 " << tokens.getLines().size() << " 行");
+  includeStack.assign(1, inputFile);
   firstPass();
-  secondPass();
+  if (isOnePass)
+  {
+    finishOnePass();
+    handleSegmentTable();
+  }
+  else
+  {
+    secondPass();
+  }
   writeFile(outputFile);
+  writeDependencyFile(inputFile, outputFile);
 }
 
-// 封装的写入文件的函数
-void Assembler::writeFile(const std::string &outputFile)
+void Assembler::setSharedEncodeCache(bool shared)
+{
+  encodeCache = shared ? &EncodeCache::shared() : &ownEncodeCache;
+}
+
+void Assembler::printStats(std::ostream &os) const
 {
-  // 打开二进制文件进行写入
-  std::ofstream outFile(outputFile, std::ios::binary);
-  if (!outFile)
+  os << "编码缓存：命中 " << encodeCache->getHits() << "，未命中 " << encodeCache->getMisses()
+     << "，缓存项 " << encodeCache->size() << std::endl;
+  os << "符号表：" << symbolTable.size() << " 个符号" << std::endl;
+  os << ".include 缓存：命中 " << IncludeCache::getHits() << "，未命中 " << IncludeCache::getMisses() << std::endl;
+  os << "宏展开缓存：命中 " << macros.getHits() << "，未命中 " << macros.getMisses() << std::endl;
+}
+
+// 流式汇编：按固定大小分块读取源文件，边读边编码，只为前向引用保留修补记录
+void Assembler::assembleStream(const std::string &inputFile, const std::string &outputFile)
+{
+  isUsingElfWriter = false;
+  isStreaming = true;
+  isOnePass = true;
+
+  bool isStdin = inputFile == "-";
+  int fd = isStdin ? STDIN_FILENO : open(inputFile.c_str(), O_RDONLY);
+  if (fd < 0)
   {
-    std::cerr << "无法打开文件 " << outputFile << " 进行写入。" << std::endl;
+    std::cerr << "无法打开文件 " << inputFile << " 进行读取。" << std::endl;
     return;
   }
+  // 标准输出不能回退修补，输出先留在内存里（每条指令 4 字节），结束时一次写出
+  streamToStdout = outputFile == "-";
+  if (streamToStdout)
+  {
+    log = &std::cerr;
+  }
+  else
+  {
+    streamOut.open(outputFile, std::ios::binary | std::ios::trunc);
+    if (!streamOut)
+    {
+      std::cerr << "无法打开文件 " << outputFile << " 进行写入。" << std::endl;
+      if (!isStdin)
+      {
+        close(fd);
+      }
+      return;
+    }
+  }
 
-  for (uint32_t instr : instructionResult)
+  initializeSegments();
+  includeStack.assign(1, inputFile);
+
+  std::vector<char> chunk(STREAM_CHUNK_SIZE);
+  std::string partial; // 跨块的不完整行
+  ssize_t n;
+  while ((n = read(fd, chunk.data(), chunk.size())) > 0)
   {
-    uint32_t dataToWrite = Utils::toLittleEndian(instr); // 确保数据以小端序写入
+    std::string_view block(chunk.data(), n);
+    size_t pos = 0;
+    size_t end;
+    while ((end = block.find('\n', pos)) != std::string_view::npos)
+    {
+      std::string_view raw = block.substr(pos, end - pos);
+      if (!partial.empty())
+      {
+        partial.append(raw);
+        raw = partial;
+      }
+      std::string_view line = LineScanner::cleanLine(raw);
+      if (!line.empty())
+      {
+        handleStreamLine(line);
+      }
+      partial.clear();
+      pos = end + 1;
+    }
+    partial.append(block.substr(pos));
+  }
+  if (!isStdin)
+  {
+    close(fd);
+  }
 
-    // 使用模板函数写入数据
-    Utils::writeBinary(outFile, dataToWrite);
+  std::string_view line = LineScanner::cleanLine(partial);
+  if (!line.empty())
+  {
+    handleStreamLine(line);
   }
 
-  outFile.close();
-  std::cout << "指令已写入文件 " << outputFile << std::endl;
+  finishOnePass();
+  if (streamToStdout)
+  {
+    if (!Utils::writeFully(STDOUT_FILENO, streamBuffer.data(), streamBuffer.size() * sizeof(uint32_t)))
+    {
+      std::cerr << "写入标准输出失败。" << std::endl;
+    }
+    std::vector<uint32_t>().swap(streamBuffer);
+  }
+  else
+  {
+    streamOut.close();
+  }
+  *log << "指令已写入文件 " << outputFile << std::endl;
+  writeDependencyFile(inputFile, outputFile);
 }
 
-// 读取文件的每一行
-std::vector<std::string> Assembler::readAssemblyCode(const std::string &filename)
+// 流式模式下逐行分词，词法单元只保留到本行处理完毕
+void Assembler::handleStreamLine(std::string_view line)
 {
-  std::ifstream infile(filename);
-  std::vector<std::string> lines;
-  std::string line;
+  streamTokens.reset(line.data());
+  Lexer::lexLine(line, streamTokens);
+  handleLine(streamTokens, streamTokens.getLines().back());
+}
 
-  while (std::getline(infile, line))
+// 一遍扫描时处理一条指令：编码缓存命中的直接写出；平坦模式下不引用符号的指令先占好位置，
+// 攒成一段后交给 BatchEncoder（流式模式逐条写出，不攒）
+void Assembler::emitInstruction(const Instruction &instruction, uint32_t cached)
+{
+  if (!isStreaming && cached == EncodeCache::NO_ENTRY && BatchEncoder::accepts(instruction))
   {
-    // 删除行内注释
-    size_t commentPos = line.find('#');
-    if (commentPos != std::string::npos)
+    if (batch.size() == 0)
     {
-      line = line.substr(0, commentPos); // 保留注释前的内容
+      batchOffset = outputOffset;
     }
-
-    line = Utils::trim(line);
-    if (!line.empty())
+    batch.push(instruction);
+    outputOffset += 4;
+    if (batch.size() == ONE_PASS_BATCH)
     {
-      lines.push_back(line);
+      flushBatch();
     }
+    return;
+  }
+
+  flushBatch(); // 攒着的指令必须紧挨着，之后的字接在它们后面
+  if (cached != EncodeCache::NO_ENTRY)
+  {
+    const EncodeCache::Entry &entry = (*encodeCache)[cached];
+    writeWords(outputOffset, entry.words, entry.count);
+    outputOffset += entry.count * 4;
+  }
+  else
+  {
+    handleOnePassInstruction(instruction);
   }
-  return lines;
 }
 
-// std::string name;           // 段名称
-// uint32_t alignment;         // 段对齐
-// std::string flags;          // 段标志
-// std::string type;           // 段类型
-// std::string segmentName;    // 段所属节的名称
-// std::uint32_t section_size; // 段大小
-// std::vector<uint8_t> data;  // 段数据
-void Assembler::firstPass()
+// 编码攒着的一段指令，写到占好的位置
+void Assembler::flushBatch()
 {
-  initializeSegments();
+  if (batch.size() == 0)
+  {
+    return;
+  }
+  size_t index = batchOffset / 4;
+  if (instructionResult.size() < index + batch.size())
+  {
+    instructionResult.resize(index + batch.size());
+  }
+  BatchEncoder::encode(batch, instructionResult.data() + index);
+  batch.clear();
+}
+
+// 编码一条指令：符号已定义的修补记录立即回填，其余连同指令模板一起挂到该符号的修补链上，
+// 等符号定义后只回填对应的字
+void Assembler::handleOnePassInstruction(const Instruction &instruction)
+{
+  uint32_t machineCode[Instruction::MAX_ENCODED_WORDS];
+  size_t count = instruction.encode(gaddress, machineCode, instructionFixups);
 
-  for (const auto &line : lines)
+  for (const Fixup &fixup : instructionFixups.items())
   {
-    if (line.back() == ':')
-    { // 处理标签
-      std::string label = line.substr(0, line.size() - 1);
-      if (!symbolTable.hasSymbol(label))
+    std::string_view name = StringPool::str(fixup.symbol);
+    uint32_t number;
+    bool forward;
+    if (isLocalLabelReference(name, number, forward))
+    {
+      LocalLabel &label = localLabel(number);
+      if (forward)
       {
-        symbolTable.addSymbol(label, saddress, gaddress, SymbolType::LABEL, false, currentSecName);
+        chainFixup(label.forward, PendingFixup{fixup, outputOffset + fixup.offset, machineCode[fixup.offset / 4], NO_FIXUP});
+      }
+      else if (label.defined)
+      {
+        machineCode[fixup.offset / 4] |= FixupList::immediateBits(fixup, label.address);
       }
       else
       {
-        symbolTable.updateSymbolAddress(label, saddress, gaddress, inSecAddress);
-        symbolTable.setType(label, SymbolType::LABEL);
-        symbolTable.setSectionName(label, currentSecName);
-        auto segName = sectionTable[currentSecName].getSegmentName();
-        symbolTable.setSegmentName(label, segName);
+        throw std::runtime_error("Undefined local label: " + std::string(StringPool::str(fixup.symbol)));
       }
+      continue;
     }
-    else if (line[0] == '.')
-    { // 处理伪指令
-      std::istringstream iss(line);
-      std::string directive;
-      iss >> directive;
-      if (directive == ".text")
+
+    if (isFunctionScratchLabel(name))
+    {
+      SymbolId id = scratchSymbols.reference(fixup.symbol);
+      const Symbol &symbol = scratchSymbols[id];
+      if (!symbol.isReferenceOnly())
       {
-        isText = true;
-        saddress = segAddressTable[".text"];
+        machineCode[fixup.offset / 4] |= FixupList::immediateBits(fixup, symbol.getGAddress());
+        continue;
       }
-      else if (directive == ".type")
+      const Symbol *defined = symbolTable.findSymbol(fixup.symbol);
+      if ((defined == nullptr || defined->getType() == SymbolType::UNDEFINED) && closedLabels.count(fixup.symbol) == 0)
       {
-        handleTypeDirective(iss, currentSecName);
+        if (scratchChains.size() <= id)
+        {
+          scratchChains.resize(scratchSymbols.size(), FixupChain{NO_FIXUP, NO_FIXUP});
+        }
+        chainFixup(scratchChains[id], PendingFixup{fixup, outputOffset + fixup.offset, machineCode[fixup.offset / 4], NO_FIXUP});
+        continue;
       }
-      else if (directive == ".globl")
+      // 函数外或之前的函数中已定义，按下面的方式处理
+    }
+    if (isScratchLabel(name))
+    {
+      auto closed = closedLabels.find(fixup.symbol);
+      if (closed != closedLabels.end())
       {
-        handleGloblDirective(iss);
+        machineCode[fixup.offset / 4] |= FixupList::immediateBits(fixup, closed->second.address);
+        continue;
       }
-      else if (directive == ".section")
+    }
+
+    SymbolId id = symbolTable.reference(fixup.symbol);
+    const Symbol &symbol = symbolTable[id];
+    if (!symbol.isReferenceOnly() && symbol.getType() != SymbolType::UNDEFINED)
+    {
+      uint32_t bits = 0;
+      FixupList::resolveOne(fixup, symbolTable, relocationTable, 0, bits);
+      machineCode[fixup.offset / 4] |= bits;
+      continue;
+    }
+
+    if (pendingChains.size() <= id)
+    {
+      pendingChains.resize(symbolTable.size(), FixupChain{NO_FIXUP, NO_FIXUP});
+    }
+    chainFixup(pendingChains[id], PendingFixup{fixup, outputOffset + fixup.offset, machineCode[fixup.offset / 4], NO_FIXUP});
+  }
+  instructionFixups.clear();
+
+  writeWords(outputOffset, machineCode, count);
+  outputOffset += count * 4;
+}
+
+// 保存一条等待中的修补记录并接到链尾，回填时按引用出现的顺序
+void Assembler::chainFixup(FixupChain &chain, const PendingFixup &pending)
+{
+  uint32_t index;
+  if (!freeFixups.empty())
+  {
+    index = freeFixups.back();
+    freeFixups.pop_back();
+    pendingFixups[index] = pending;
+  }
+  else
+  {
+    index = pendingFixups.size();
+    pendingFixups.push_back(pending);
+  }
+
+  if (chain.head == NO_FIXUP)
+  {
+    chain.head = index;
+  }
+  else
+  {
+    pendingFixups[chain.tail].next = index;
+  }
+  chain.tail = index;
+}
+
+Assembler::LocalLabel &Assembler::localLabel(uint32_t number)
+{
+  if (number >= MAX_LOCAL_LABEL)
+  {
+    throw std::runtime_error("Local label number out of range: " + std::to_string(number));
+  }
+  if (localLabels.size() <= number)
+  {
+    localLabels.resize(number + 1, LocalLabel{0, false, FixupChain{NO_FIXUP, NO_FIXUP}});
+  }
+  return localLabels[number];
+}
+
+// 数字局部标签定义在当前地址：回填等待它的 Nf 引用，之后的 Nb 引用指向这里
+void Assembler::defineLocalLabel(uint32_t number)
+{
+  LocalLabel &label = localLabel(number);
+  label.address = gaddress;
+  label.defined = true;
+  uint32_t index = label.forward.head;
+  label.forward = FixupChain{NO_FIXUP, NO_FIXUP};
+  while (index != NO_FIXUP)
+  {
+    uint32_t next = pendingFixups[index].next;
+    patchFixup(index, FixupList::immediateBits(pendingFixups[index].fixup, gaddress));
+    index = next;
+  }
+}
+
+// 一遍扫描时在函数内（.type @function 到该函数的 .size 之间）出现的 .L 标签才放进临时表
+bool Assembler::isFunctionScratchLabel(std::string_view name) const
+{
+  return isOnePass && currentFunction != 0 && isScratchLabel(name);
+}
+
+// .L 标签定义在当前地址：记入当前函数的临时表，回填本函数中等待它的字
+void Assembler::defineScratchLabel(Atom label)
+{
+  const Symbol *global = symbolTable.findSymbol(label);
+  if (scratchSymbols.find(label) != SymbolTable::NO_SYMBOL || closedLabels.count(label) != 0 ||
+      (global && global->getType() == SymbolType::LABEL))
+  {
+    throw std::runtime_error("Symbol already defined: " + std::string(StringPool::str(label)));
+  }
+  SymbolId id = scratchSymbols.intern(label);
+  Symbol &symbol = scratchSymbols[id];
+  symbol.setSAddress(saddress);
+  symbol.setGAddress(gaddress);
+  symbol.setInSecAddress(inSecAddress);
+  symbol.setType(SymbolType::LABEL);
+  symbol.setSectionName(currentSecName);
+  symbol.setSegmentName(sectionTable[currentSecName].getSegmentId());
+  if (id >= scratchChains.size())
+  {
+    return;
+  }
+  uint32_t index = scratchChains[id].head;
+  scratchChains[id] = FixupChain{NO_FIXUP, NO_FIXUP};
+  while (index != NO_FIXUP)
+  {
+    uint32_t next = pendingFixups[index].next;
+    patchFixup(index, FixupList::immediateBits(pendingFixups[index].fixup, gaddress));
+    index = next;
+  }
+}
+
+// 函数结束：本函数中定义的 .L 标签只把地址和大小留在 closedLabels 里（后面的函数引用时直接回填），
+// 仍未定义的把修补链接到符号表中同名符号的链上（之后定义时回填，到最后也没有定义时按外部符号处理），
+// 然后清空临时表
+void Assembler::closeScratchScope()
+{
+  for (SymbolId id = 0; id < scratchSymbols.size(); id++)
+  {
+    Atom name = scratchSymbols.getName(id);
+    const Symbol &scratch = scratchSymbols[id];
+    if (!scratch.isReferenceOnly())
+    {
+      int size = scratchSymbols.getSymbolSize(id);
+      SymbolId global = symbolTable.find(name);
+      if (global == SymbolTable::NO_SYMBOL)
+      {
+        closedLabels[name] = ClosedLabel{scratch.getGAddress(), size};
+      }
+      else if (size != 0)
       {
-        handleSectionDirective(iss, currentSecName);
+        symbolTable.setSymbolSize(global, size); // 定义时已经同时记入符号表
       }
-      else if (directive == ".p2align")
+      continue;
+    }
+    if (id >= scratchChains.size() || scratchChains[id].head == NO_FIXUP)
+    {
+      continue;
+    }
+
+    SymbolId global = symbolTable.reference(name);
+    const Symbol &symbol = symbolTable[global];
+    bool defined = !symbol.isReferenceOnly() && symbol.getType() != SymbolType::UNDEFINED;
+    if (pendingChains.size() <= global)
+    {
+      pendingChains.resize(symbolTable.size(), FixupChain{NO_FIXUP, NO_FIXUP});
+    }
+    FixupChain &chain = pendingChains[global];
+    if (chain.head == NO_FIXUP)
+    {
+      chain.head = scratchChains[id].head;
+    }
+    else
+    {
+      pendingFixups[chain.tail].next = scratchChains[id].head;
+    }
+    chain.tail = scratchChains[id].tail;
+    if (defined)
+    {
+      resolvePendingSymbol(global);
+    }
+  }
+  scratchSymbols.clear();
+  scratchChains.clear();
+}
+
+// 标签的全局地址（.size 的表达式用）：一遍扫描时函数内的 .L 标签先查当前函数的临时表
+uint32_t Assembler::labelAddress(std::string_view name)
+{
+  if (isFunctionScratchLabel(name))
+  {
+    if (const Symbol *symbol = scratchSymbols.findSymbol(StringPool::intern(name)))
+    {
+      return symbol->getGAddress();
+    }
+  }
+  if (isOnePass && isScratchLabel(name))
+  {
+    auto closed = closedLabels.find(StringPool::intern(name));
+    if (closed != closedLabels.end())
+    {
+      return closed->second.address;
+    }
+  }
+  return symbolTable.getSymbol(name).getGAddress();
+}
+
+// .size 设置的大小：一遍扫描时不在符号表中的 .L 标签记在临时表或 closedLabels 里
+void Assembler::setLabelSize(Atom name, int size)
+{
+  SymbolId id = isOnePass ? scratchSymbols.find(name) : SymbolTable::NO_SYMBOL;
+  if (id != SymbolTable::NO_SYMBOL)
+  {
+    scratchSymbols.setSymbolSize(id, size);
+    return;
+  }
+  auto closed = isOnePass ? closedLabels.find(name) : closedLabels.end();
+  if (closed != closedLabels.end())
+  {
+    closed->second.size = size;
+    return;
+  }
+  symbolTable.setSize(name, size);
+}
+
+// 符号定义后沿修补链回填所有等待该符号的字
+void Assembler::resolvePendingSymbol(SymbolId symbol)
+{
+  if (symbol >= pendingChains.size() || pendingChains[symbol].head == NO_FIXUP)
+  {
+    return;
+  }
+  uint32_t index = pendingChains[symbol].head;
+  pendingChains[symbol] = FixupChain{NO_FIXUP, NO_FIXUP};
+  while (index != NO_FIXUP)
+  {
+    // 符号仍不存在时生成重定位项，字保持模板不变
+    uint32_t next = pendingFixups[index].next;
+    uint32_t bits = 0;
+    FixupList::resolveOne(pendingFixups[index].fixup, symbolTable, relocationTable, 0, bits);
+    patchFixup(index, bits);
+    index = next;
+  }
+}
+
+// 把立即数的位或进等待中的字并写回，释放这条修补记录
+void Assembler::patchFixup(uint32_t index, uint32_t bits)
+{
+  const PendingFixup &pending = pendingFixups[index];
+  uint32_t word = pending.word | bits;
+  writeWords(pending.outputOffset, &word, 1);
+  freeFixups.push_back(index);
+}
+
+// 输入结束：仍未定义的符号按外部符号处理（生成重定位项），按符号句柄的顺序
+void Assembler::finishOnePass()
+{
+  flushBatch();
+  closeScratchScope();
+  for (SymbolId id = 0; id < pendingChains.size(); id++)
+  {
+    resolvePendingSymbol(id);
+  }
+  for (uint32_t number = 0; number < localLabels.size(); number++)
+  {
+    if (localLabels[number].forward.head != NO_FIXUP)
+    {
+      throw std::runtime_error("Undefined local label: " + std::to_string(number) + "f");
+    }
+  }
+  localLabels.clear();
+  closedLabels.clear();
+  currentFunction = 0;
+  pendingChains.clear();
+  pendingFixups.clear();
+  freeFixups.clear();
+}
+
+// 在输出的指定偏移处写入机器码：平坦模式写到 instructionResult，流式模式写到输出文件（小端序）
+void Assembler::writeWords(uint64_t offset, const uint32_t *words, size_t count)
+{
+  if (!isStreaming)
+  {
+    size_t index = offset / 4;
+    if (instructionResult.size() < index + count)
+    {
+      instructionResult.resize(index + count);
+    }
+    std::copy(words, words + count, instructionResult.begin() + index);
+    return;
+  }
+  if (streamToStdout)
+  {
+    size_t index = offset / 4;
+    if (streamBuffer.size() < index + count)
+    {
+      streamBuffer.resize(index + count);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      streamBuffer[index++] = Utils::toLittleEndian(words[i]);
+    }
+    return;
+  }
+  bool append = offset == outputOffset;
+  if (!append)
+  {
+    streamOut.seekp(offset);
+  }
+  for (size_t i = 0; i < count; i++)
+  {
+    Utils::writeBinary(streamOut, Utils::toLittleEndian(words[i]));
+  }
+  if (!append)
+  {
+    streamOut.seekp(outputOffset);
+  }
+}
+
+// 封装的写入文件的函数：整个输出先拼成一块缓冲区，再一次写出（输出文件为 "-" 时写到标准输出）
+void Assembler::writeFile(const std::string &outputFile)
+{
+  int fd = Utils::openOutput(outputFile);
+  if (fd < 0)
+  {
+    std::cerr << "无法打开文件 " << outputFile << " 进行写入。" << std::endl;
+    return;
+  }
+
+  std::vector<uint32_t> buffer;
+  buffer.reserve(instructionResult.size());
+  for (uint32_t instr : instructionResult)
+  {
+    buffer.push_back(Utils::toLittleEndian(instr)); // 确保数据以小端序写入
+  }
+  bool ok = Utils::writeFully(fd, buffer.data(), buffer.size() * sizeof(uint32_t));
+  if (fd != STDOUT_FILENO)
+  {
+    close(fd);
+  }
+  if (!ok)
+  {
+    std::cerr << "写入文件 " << outputFile << " 失败。" << std::endl;
+    return;
+  }
+  *log << "指令已写入文件 " << outputFile << std::endl;
+}
+
+// 读取文件的每一行
+std::vector<std::string_view> Assembler::readAssemblyCode(const std::string &filename)
+{
+  // 映射整个文件并建立行索引，各行以视图的形式引用映射区
+  if (!source.open(filename))
+  {
+    std::cerr << "无法打开文件 " << filename << " 进行读取。" << std::endl;
+    return {};
+  }
+  return source.buildLineIndex();
+}
+
+// std::string name;           // 段名称
+// uint32_t alignment;         // 段对齐
+// std::string flags;          // 段标志
+// std::string type;           // 段类型
+// std::string segmentName;    // 段所属节的名称
+// std::uint32_t section_size; // 段大小
+// std::vector<uint8_t> data;  // 段数据
+void Assembler::firstPass()
+{
+  initializeSegments();
+  arenas.assign(1, &tokens);
+  arenaIndex.clear();
+  arenaIndex.emplace(&tokens, 0);
+  currentArena = 0;
+
+  const std::vector<LexedLine> &lexedLines = tokens.getLines();
+  for (const LexedLine &line : lexedLines)
+  {
+    handleLine(tokens, line);
+  }
+}
+
+// 处理一行汇编代码：标签、伪指令或指令
+void Assembler::handleLine(const TokenArena &arena, const LexedLine &lexed)
+{
+  std::string_view line = arena.text(lexed);
+  if (macros.isRecording())
+  { // 宏体或重复块内的行只记录，块结束时再展开
+    std::string_view directive = lexed.kind == LineKind::Directive ? arena.text(*arena.begin(lexed)) : std::string_view();
+    const TokenArena *expansion;
+    if (macros.recordLine(directive, line, expansion) && expansion)
+    {
+      handleArena(*expansion);
+    }
+    return;
+  }
+  if (lexed.kind == LineKind::Instruction && lexed.tokenCount > 0)
+  { // 宏调用：展开结果直接交给标签、伪指令和指令的处理流程
+    const Token &name = *arena.begin(lexed);
+    if (name.kind == TokenKind::Identifier && macros.isMacro(arena.text(name)))
+    {
+      handleArena(*macros.expandMacro(arena.text(name), line.substr(name.offset + name.length - lexed.offset)));
+      return;
+    }
+  }
+  if (lexed.kind == LineKind::Label)
+  { // 处理标签
+    std::string_view name = line.substr(0, line.size() - 1);
+    uint32_t number;
+    if (Utils::parseLocalLabel(name, number))
+    { // 数字局部标签只在一遍扫描中按出现顺序解析，不进符号表
+      if (!isOnePass)
       {
-        handleP2AlignDirective(iss, currentSecName);
+        throw std::runtime_error("Numeric local labels require one-pass assembly: " + std::string(line));
       }
-      else if (directive == ".size")
+      defineLocalLabel(number);
+      return;
+    }
+    Atom label = StringPool::intern(name);
+    if (isFunctionScratchLabel(name))
+    {
+      defineScratchLabel(label);
+      if (symbolTable.lookup(label) == SymbolTable::NO_SYMBOL)
       {
-        handleSizeDirective(iss, currentSecName);
+        return; // 之前的函数没有引用过它，也没有用伪指令声明过，只留在临时表里
       }
-      else if (directive == ".word")
+    }
+    SymbolId id = symbolTable.find(label);
+    if (id == SymbolTable::NO_SYMBOL)
+    {
+      if (isOnePass && closedLabels.count(label) != 0)
       {
-        handleWordDirective(iss, currentSecName);
+        throw std::runtime_error("Symbol already defined: " + std::string(name));
       }
-      else if (directive == ".asciz")
+      id = symbolTable.addSymbol(label, saddress, gaddress, SymbolType::LABEL, false, currentSecName);
+    }
+    else
+    {
+      if (symbolTable[id].getType() == SymbolType::LABEL)
       {
-        handleAscizDirective(iss, currentSecName);
+        throw std::runtime_error("Symbol already defined: " + std::string(name));
       }
+      Atom segName = sectionTable[currentSecName].getSegmentId();
+      Symbol &symbol = symbolTable[id];
+      symbol.setSAddress(saddress);
+      symbol.setGAddress(gaddress);
+      symbol.setInSecAddress(inSecAddress);
+      symbol.setType(SymbolType::LABEL);
+      symbol.setSectionName(currentSecName);
+      symbol.setSegmentName(segName);
+    }
+    if (isOnePass)
+    {
+      resolvePendingSymbol(id);
+    }
+  }
+  else if (lexed.kind == LineKind::Directive)
+  { // 处理伪指令
+    const Token &name = *arena.begin(lexed);
+    std::string_view directive = arena.text(name);
+    std::string_view rest = line.substr(name.offset + name.length - lexed.offset); // 伪指令名之后的参数部分
+    TRACE(Directive, Debug, directive << rest);
+    if (directive == ".text")
+    {
+      isText = true;
+      saddress = segAddressTable[StringPool::intern(".text")];
+    }
+    else if (directive == ".type")
+    {
+      handleTypeDirective(rest, currentSecName);
+    }
+    else if (directive == ".globl")
+    {
+      handleGloblDirective(rest);
+    }
+    else if (directive == ".section")
+    {
+      handleSectionDirective(rest, currentSecName);
+    }
+    else if (directive == ".p2align")
+    {
+      handleP2AlignDirective(rest, currentSecName);
+    }
+    else if (directive == ".size")
+    {
+      handleSizeDirective(rest, currentSecName);
+    }
+    else if (directive == ".word")
+    {
+      handleWordDirective(rest, currentSecName);
+    }
+    else if (directive == ".asciz")
+    {
+      handleAscizDirective(rest, currentSecName);
+    }
+    else if (directive == ".include")
+    {
+      handleIncludeDirective(arena, lexed);
+    }
+    else if (directive == ".macro")
+    {
+      macros.beginMacro(rest);
+    }
+    else if (directive == ".rept")
+    {
+      macros.beginRept(rest);
+    }
+    else if (directive == ".irp")
+    {
+      macros.beginIrp(rest);
+    }
+    else if (directive == ".endm" || directive == ".endr")
+    {
+      throw std::runtime_error("Unmatched " + std::string(directive) + " directive");
+    }
+  }
+  else
+  {
+    // 只解析这一次，一遍扫描时立即编码，两遍扫描时第二遍直接编码解码结果；不引用符号的指令先查编码缓存
+    uint32_t cached = encodeCache->find(arena, lexed);
+    Instruction instruction;
+    if (cached != EncodeCache::NO_ENTRY)
+    {
+      instruction = (*encodeCache)[cached].instruction;
+    }
+    else
+    {
+      instruction = Instruction::decode(arena, lexed);
+      cached = encodeCache->insert(instruction);
+    }
+    if (isOnePass)
+    {
+      TRACE(Encode, Debug, "正在处理指令：" << line);
+      emitInstruction(instruction, cached);
     }
     else
     {
-      std::pair<int, std::string> instrucionPair = std::make_pair(saddress, line);
-      instructionTable[currentSecName].emplace_back(instrucionPair);
-      instructionVector.emplace_back(std::make_pair(gaddress, line));
-      saddress += 4;
-      gaddress += 4;
-      inSecAddress += 4;
+      uint32_t number;
+      bool forward;
+      if (isLocalLabelReference(StringPool::str(instruction.symbol), number, forward))
+      {
+        throw std::runtime_error("Numeric local labels require one-pass assembly: " + std::string(line));
+      }
+      LineRef ref{currentArena, static_cast<uint32_t>(&lexed - arena.getLines().data())};
+      if (isUsingElfWriter)
+      {
+        instructionTable[currentSecName].push_back({saddress, ref, instruction, cached});
+      }
+      else
+      {
+        instructionVector.push_back({gaddress, ref, instruction, cached});
+      }
     }
+    saddress += 4;
+    gaddress += 4;
+    inSecAddress += 4;
   }
 }
 
@@ -166,53 +861,100 @@ void Assembler::secondPass()
 {
   if (isUsingElfWriter)
   {
-    for (auto &instr : instructionTable)
+    for (const auto &instr : instructionTable)
     {
-      std::string secName = instr.first;
-      std::vector<std::pair<int, std::string>> instructionPair = instr.second;
-      for (auto &pair : instructionPair)
-      {
-        int address = pair.first;
-        std::string line = pair.second;
-        handleInstruction(address, line, secName);
-      }
+      encodeInstructions(instr.second, instr.first);
+      Section &section = sectionTable[instr.first];
+      fixups.resolve(symbolTable, relocationTable, instr.first, [&section](uint32_t offset, uint32_t bits)
+                     { section.patchInstruction(offset, bits); });
     }
     handleSegmentTable();
   }
   else
   {
-    for (auto &instr : instructionVector)
+    encodeInstructions(instructionVector, 0);
+    fixups.resolve(symbolTable, relocationTable, 0, [this](uint32_t offset, uint32_t bits)
+                   { instructionResult[offset / 4] |= bits; });
+    handleSegmentTable();
+  }
+}
+
+void Assembler::encodeInstructions(const std::vector<DecodedLine> &lines, Atom currentSecName)
+{
+  size_t i = 0;
+  while (i < lines.size())
+  {
+    // 命中编码缓存的指令直接复制，不进入批量编码
+    size_t end = i;
+    while (end < lines.size() && lines[end].cached == EncodeCache::NO_ENTRY && BatchEncoder::accepts(lines[end].instruction))
     {
-      uint32_t addr = instr.first;
-      std::string instruction = instr.second;
-      handleInstruction(addr, instruction, "");
+      end++;
+    }
+    if (end - i >= MIN_BATCH)
+    {
+      handleInstructionBatch(lines.data() + i, end - i, currentSecName);
+      i = end;
+      continue;
+    }
+    for (end = std::max(end, i + 1); i < end; i++)
+    {
+      handleInstruction(lines[i], currentSecName);
     }
-    handleSegmentTable();
   }
 }
 
-void Assembler::handleTypeDirective(std::istringstream &iss, std::string &currentSecName)
+// 指令所在的源行文本
+std::string_view Assembler::lineText(LineRef line) const
 {
-  //.type	factorial,@function
-  // 读取 .type 后面的整行内容
-  std::string restOfLine;
-  std::getline(iss, restOfLine);
+  const TokenArena &arena = *arenas[line.arena];
+  return arena.text(arena.getLines()[line.line]);
+}
 
-  // 去除首尾空白
-  restOfLine = Utils::trim(restOfLine);
+// 一段不引用符号的指令：字段转成结构数组后一次编码
+void Assembler::handleInstructionBatch(const DecodedLine *lines, size_t count, Atom currentSecName)
+{
+  batch.clear();
+  for (size_t i = 0; i < count; i++)
+  {
+    TRACE(Encode, Debug, "正在处理指令：" << lineText(lines[i].line) << "（批量）");
+    batch.push(lines[i].instruction);
+  }
 
-  // 使用 split 函数按逗号分割
-  std::vector<std::string> parts = Utils::split(restOfLine, ',');
+  if (isUsingElfWriter)
+  {
+    batchWords.resize(count);
+    BatchEncoder::encode(batch, batchWords.data());
+    sectionTable[currentSecName].addInstruction(batchWords.data(), count);
+  }
+  else
+  {
+    size_t offset = instructionResult.size();
+    instructionResult.resize(offset + count);
+    BatchEncoder::encode(batch, instructionResult.data() + offset);
+  }
+}
 
-  // 检查分割结果是否有效
-  if (parts.size() != 2)
+void Assembler::handleTypeDirective(std::string_view rest, Atom &currentSecName)
+{
+  //.type	factorial,@function
+  // 按逗号切分 .type 后面的内容
+  ArgCursor args(rest);
+  std::string_view symbol, type;
+  if (args.count() != 2 || !args.next(symbol) || !args.next(type))
   {
-    throw std::runtime_error("Invalid format in .type directive: " + restOfLine);
+    throw std::runtime_error("Invalid format in .type directive: " + std::string(Utils::trimView(rest)));
   }
-  currentSecName = Utils::trim(parts[0]);
-  std::string type = Utils::trim(parts[1]);
+  currentSecName = StringPool::intern(symbol);
 
   // 设置符号类型
+  if (type == "@function")
+  {
+    if (isOnePass && currentFunction != 0)
+    {
+      closeScratchScope(); // 上一个函数没有 .size
+    }
+    currentFunction = currentSecName;
+  }
   if (type == "@function" || type == "@object")
   {
     if (sectionTable.find(currentSecName) == sectionTable.end())
@@ -221,7 +963,7 @@ void Assembler::handleTypeDirective(std::istringstream &iss, std::string &curren
       inSecAddress = 0;
       if (type == "@function")
       {
-        sectionTable[currentSecName].setSegmentName(".text");
+        sectionTable[currentSecName].setSegmentName(StringPool::intern(".text"));
         sectionTable[currentSecName].setAlignment(1 << 2);
         sectionTable[currentSecName].setFillValue(0x0);
       }
@@ -237,25 +979,22 @@ void Assembler::handleTypeDirective(std::istringstream &iss, std::string &curren
   }
   else
   {
-    throw std::runtime_error("Unknown symbol type in .type directive: " + type);
+    throw std::runtime_error("Unknown symbol type in .type directive: " + std::string(type));
   }
 }
 
-void Assembler::handleGloblDirective(std::istringstream &iss)
+void Assembler::handleGloblDirective(std::string_view rest)
 {
-  std::string symbol;
-  if (!(iss >> symbol))
+  std::string_view symbol = ArgCursor::firstWord(rest);
+  if (symbol.empty())
   {
     throw std::runtime_error("Invalid format in .globl directive");
   }
-  if (!symbolTable.hasSymbol(symbol))
-  {
-    symbolTable.addSymbol(symbol);
-  }
-  symbolTable.setGlobal(symbol, true);
-  if (currentSecName.empty())
+  Atom symbolId = StringPool::intern(symbol);
+  symbolTable[symbolTable.intern(symbolId)].setGlobal(true);
+  if (currentSecName == 0)
   {
-    currentSecName = symbol;
+    currentSecName = symbolId;
   }
   // if (sectionTable.find(currentSecName) == sectionTable.end())
   // {
@@ -264,52 +1003,52 @@ void Assembler::handleGloblDirective(std::istringstream &iss)
   // }
 }
 
-void Assembler::handleSectionDirective(std::istringstream &iss, std::string &currentSecName)
+void Assembler::handleSectionDirective(std::string_view rest, Atom &currentSecName)
 {
   //.section	.rodata,"a",@progbits
-  // 读取 .section 后的所有内容
-  std::string restOfLine;
-  std::getline(iss, restOfLine);
-  restOfLine = Utils::trim(restOfLine);
-
   // 分割成节名、标志、类型
-  std::vector<std::string> sectionParts = Utils::split(restOfLine, ',');
-
-  if (sectionParts.size() < 1)
+  ArgCursor sectionParts(rest);
+  std::string_view segmentPart, flagsPart, typePart;
+  if (!sectionParts.next(segmentPart))
   {
-    throw std::runtime_error("Invalid .section directive format: " + restOfLine);
+    throw std::runtime_error("Invalid .section directive format: " + std::string(Utils::trimView(rest)));
   }
 
   // 解析节名
-  std::string segmentName = Utils::trim(sectionParts[0]);
+  Atom segmentName = StringPool::intern(segmentPart);
   // 解析标志和类型，如果有的话
-  std::string flags = (sectionParts.size() > 1) ? Utils::trim(sectionParts[1]) : "";
-  std::string type = (sectionParts.size() > 2) ? Utils::trim(sectionParts[2]) : "";
+  Atom flags = sectionParts.next(flagsPart) ? StringPool::intern(flagsPart) : 0;
+  Atom type = sectionParts.next(typePart) ? StringPool::intern(typePart) : 0;
   sectionTable[currentSecName].setSegmentName(segmentName);
   sectionTable[currentSecName].setFlags(flags);
   sectionTable[currentSecName].setType(type);
   saddress = segAddressTable[segmentName];
 }
 
-void Assembler::handleP2AlignDirective(std::istringstream &iss, const std::string &currentSecName)
+void Assembler::handleP2AlignDirective(std::string_view rest, Atom currentSecName)
 {
-  // 获取对齐参数行，并去除多余空格
-  std::string restOfLine;
-  std::getline(iss, restOfLine);
   if (!isText)
   {
-    restOfLine = Utils::trim(restOfLine);
-
     // 分割参数，去除空白
-    auto alignArgs = Utils::split(restOfLine, ',');
-
-    if (alignArgs.empty())
+    ArgCursor alignArgs(rest);
+    std::string_view alignPart, fillPart;
+    if (!alignArgs.next(alignPart))
     {
       throw std::runtime_error("Missing alignment value in .p2align directive");
     }
 
-    int align = std::stoi(Utils::trim(alignArgs[0]));
-    uint8_t fillValue = (alignArgs.size() > 1) ? std::stoi(Utils::trim(alignArgs[1]), nullptr, 0) : 0;
+    int32_t align;
+    ParseStatus status = ArgCursor::parseInt(alignPart, align);
+    if (status != ParseStatus::Ok)
+    {
+      throw std::runtime_error(std::string("Invalid alignment value in .p2align directive: ") + Utils::immediateError(status, alignPart).what());
+    }
+    int32_t fill = 0;
+    if (alignArgs.next(fillPart) && (status = ArgCursor::parseInt(fillPart, fill)) != ParseStatus::Ok)
+    {
+      throw std::runtime_error(std::string("Invalid fill value in .p2align directive: ") + Utils::immediateError(status, fillPart).what());
+    }
+    uint8_t fillValue = static_cast<uint8_t>(fill);
 
     if (align < 0 || align > 31)
     {
@@ -322,73 +1061,97 @@ void Assembler::handleP2AlignDirective(std::istringstream &iss, const std::strin
   }
 }
 
-void Assembler::handleSizeDirective(std::istringstream &iss, const std::string &currentSecName)
+void Assembler::handleSizeDirective(std::string_view rest, Atom currentSecName)
 {
   // 读取符号名称和大小部分
-  std::string sizeLine;
-  std::getline(iss, sizeLine);                                      // 获取完整的行内容
-  std::vector<std::string> sizeParts = Utils::split(sizeLine, ','); // 按逗号分割
-  if (sizeParts.size() != 2 || sizeParts[0] != currentSecName)
+  ArgCursor sizeParts(rest);
+  std::string_view symbolPart, sizeExpr;
+  if (sizeParts.count() != 2 || !sizeParts.next(symbolPart) || !sizeParts.next(sizeExpr) ||
+      symbolPart != StringPool::str(currentSecName))
   {
-    throw std::runtime_error("Invalid format in .size directive for: " + currentSecName);
+    throw std::runtime_error("Invalid format in .size directive for: " + std::string(StringPool::str(currentSecName)));
   }
 
-  std::string symbol = sizeParts[0];
-  std::string sizeExpr = sizeParts[1];
+  Atom symbol = currentSecName;
 
-  if (sizeExpr.find('-') != std::string::npos)
+  if (sizeExpr.find('-') != std::string_view::npos)
   {
     // 表达式格式，分割并计算
-    std::vector<std::string> exprParts = Utils::split(sizeExpr, '-');
-    if (exprParts.size() == 2)
+    ArgCursor exprParts(sizeExpr, '-');
+    std::string_view startSymbol, endSymbol;
+    if (exprParts.count() == 2 && exprParts.next(startSymbol) && exprParts.next(endSymbol))
     {
-      std::string startSymbol = exprParts[0];
-      std::string endSymbol = exprParts[1];
-
       // 获取符号地址并计算差值
-      uint32_t startAddr = symbolTable.getSymbol(startSymbol).getGAddress();
-      uint32_t endAddr = symbolTable.getSymbol(endSymbol).getGAddress();
+      uint32_t startAddr = labelAddress(startSymbol);
+      uint32_t endAddr = labelAddress(endSymbol);
       uint32_t size = startAddr - endAddr;
 
-      symbolTable.setSize(symbol, size);
+      setLabelSize(symbol, size);
       sectionTable[currentSecName].setSectionSize(size);
     }
   }
   else
   {
     // 直接数值
-    int size = std::stoi(sizeExpr);
-    symbolTable.setSize(symbol, size);
+    int32_t size;
+    ParseStatus status = ArgCursor::parseInt(sizeExpr, size);
+    if (status != ParseStatus::Ok)
+    {
+      throw std::runtime_error(std::string("Invalid size in .size directive: ") + Utils::immediateError(status, sizeExpr).what());
+    }
+    setLabelSize(symbol, size);
     sectionTable[currentSecName].setSectionSize(size);
   }
-  sectionTable[currentSecName].align(sectionTable[currentSecName].getAlignment(), saddress, gaddress, inSecAddress);
-  uint32_t prevBaseAddress = baseAddressTable[sectionTable[currentSecName].getSegmentName()].first;
-  uint32_t prevSize = baseAddressTable[sectionTable[currentSecName].getSegmentName()].second;
-  sectionTable[currentSecName].setBaseAddress(prevBaseAddress + prevSize);
-  baseAddressTable[sectionTable[currentSecName].getSegmentName()].first = prevBaseAddress + prevSize;
-  baseAddressTable[sectionTable[currentSecName].getSegmentName()].second = sectionTable[currentSecName].getSize();
-  segAddressTable[sectionTable[currentSecName].getSegmentName()] = saddress;
+  Section &section = sectionTable[currentSecName];
+  section.align(section.getAlignment(), saddress, gaddress, inSecAddress);
+  std::pair<uint32_t, uint32_t> &base = baseAddressTable[section.getSegmentId()];
+  uint32_t prevBaseAddress = base.first;
+  uint32_t prevSize = base.second;
+  section.setBaseAddress(prevBaseAddress + prevSize);
+  base.first = prevBaseAddress + prevSize;
+  base.second = section.getSize();
+  segAddressTable[section.getSegmentId()] = saddress;
+
+  if (isOnePass && symbol == currentFunction)
+  {
+    closeScratchScope();
+    currentFunction = 0;
+  }
 }
 
-void Assembler::handleWordDirective(std::istringstream &iss, const std::string &currentSecName)
+void Assembler::handleWordDirective(std::string_view rest, Atom currentSecName)
 {
-  uint32_t value;
-  std::vector<uint32_t> data;
-  while (iss >> value) // 读取每个32位整数值
+  // 读取每个以空白分隔的 32 位十进制整数，遇到无法解析的内容即停止
+  std::vector<uint32_t> &data = wordScratch;
+  data.clear();
+  const char *p = rest.data();
+  const char *end = rest.data() + rest.size();
+  for (;;)
   {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    {
+      p++;
+    }
+    bool negative = p < end && *p == '-';
+    const char *digits = (p < end && (*p == '-' || *p == '+')) ? p + 1 : p;
+    uint32_t value;
+    auto [next, ec] = std::from_chars(digits, end, value);
+    if (ec != std::errc() || next == digits)
+    {
+      break;
+    }
+    p = next;
     // 将值按小端序添加到段数据
-    data.emplace_back(value);
-    sectionTable[currentSecName].addInstruction(data);
+    data.emplace_back(negative ? 0u - value : value);
+    sectionTable[currentSecName].addInstruction(data.data(), data.size());
     saddress += 4;
     gaddress += 4;
     inSecAddress += 4;
   }
 }
-void Assembler::handleAscizDirective(std::istringstream &iss, const std::string &currentSecName)
+void Assembler::handleAscizDirective(std::string_view rest, Atom currentSecName)
 {
-  std::string strValue;
-  std::getline(iss, strValue); // 获取字符串内容（包含引号）
-  strValue = Utils::trim(strValue);
+  std::string_view strValue = Utils::trimView(rest); // 字符串内容（包含引号）
 
   // 去掉首尾的引号，得到实际字符串内容
   if (strValue.size() >= 2 && strValue.front() == '"' && strValue.back() == '"')
@@ -396,7 +1159,8 @@ void Assembler::handleAscizDirective(std::istringstream &iss, const std::string
     strValue = strValue.substr(1, strValue.size() - 2);
   }
 
-  std::vector<uint8_t> data;
+  std::vector<uint8_t> &data = ascizScratch;
+  data.clear();
 
   // 逐个字符解析字符串内容，处理转义字符
   for (size_t i = 0; i < strValue.size(); ++i)
@@ -464,22 +1228,171 @@ void Assembler::handleAscizDirective(std::istringstream &iss, const std::string
   uint32_t secAlignment = sectionTable[currentSecName].getAlignment();
   sectionTable[currentSecName].align(secAlignment, saddress, gaddress, inSecAddress);
 }
-void Assembler::handleInstruction(const int address, const std::string &line, const std::string &currentSecName)
+void Assembler::handleInstruction(const DecodedLine &decoded, Atom currentSecName)
 {
-  std::cout << "正在处理指令：" << line << std::endl;
-  // 使用 Instruction 工厂方法解析并创建指令对象
-  auto instruction = Instruction::create(line);
+  TRACE(Encode, Debug, "正在处理指令：" << lineText(decoded.line));
 
-  // 编码指令，生成机器码
-  std::vector<uint32_t> machineCode = instruction->encode(symbolTable, relocationTable, sectionTable, address, currentSecName);
-  if (isUsingElfWriter)
+  // 编码第一遍解码好的指令，生成机器码（不经过临时 vector）；命中编码缓存的指令直接复制
+  if (decoded.cached != EncodeCache::NO_ENTRY)
+  {
+    const EncodeCache::Entry &entry = (*encodeCache)[decoded.cached];
+    if (isUsingElfWriter)
+    {
+      sectionTable[currentSecName].addInstruction(entry.words, entry.count);
+    }
+    else
+    {
+      instructionResult.insert(instructionResult.end(), entry.words, entry.words + entry.count);
+    }
+  }
+  else if (isUsingElfWriter)
+  {
+    // 将机器码添加到当前节的数据，引用符号的字在本节编码完后统一回填
+    Section &section = sectionTable[currentSecName];
+    uint32_t machineCode[Instruction::MAX_ENCODED_WORDS];
+    fixups.setBase(static_cast<uint32_t>(section.getData().size()));
+    size_t count = decoded.instruction.encode(decoded.address, machineCode, fixups);
+    section.addInstruction(machineCode, count);
+  }
+  else
+  {
+    // 直接编码到结果数组的末尾
+    size_t offset = instructionResult.size();
+    instructionResult.resize(offset + Instruction::MAX_ENCODED_WORDS);
+    fixups.setBase(static_cast<uint32_t>(offset * 4));
+    size_t count = decoded.instruction.encode(decoded.address, instructionResult.data() + offset, fixups);
+    instructionResult.resize(offset + count);
+  }
+}
+
+// .include "file"：文本粘贴被包含文件，其词法单元流来自进程级缓存
+void Assembler::handleIncludeDirective(const TokenArena &arena, const LexedLine &lexed)
+{
+  const Token *token = arena.begin(lexed) + 1;
+  if (lexed.tokenCount != 2 || token->kind != TokenKind::String || token->length < 2)
+  {
+    throw std::runtime_error("Invalid format in .include directive: " + std::string(arena.text(lexed)));
+  }
+  std::string path = resolveInclude(std::string(arena.text(*token).substr(1, token->length - 2)));
+  if (std::find(includeStack.begin(), includeStack.end(), path) != includeStack.end())
   {
-    // 将机器码添加到当前节的数据
-    sectionTable[currentSecName].addInstruction(machineCode);
+    throw std::runtime_error("Recursive .include of: " + path);
+  }
+  std::shared_ptr<const TokenArena> included = IncludeCache::get(path);
+  if (!included)
+  {
+    throw std::runtime_error("Cannot open included file: " + path);
+  }
+  if (std::find(includedArenas.begin(), includedArenas.end(), included) == includedArenas.end())
+  {
+    includedArenas.push_back(included);
+  }
+  TRACE(Lexer, Info, path << "：包含文件，共 " << included->getLines().size() << " 行");
+  if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+  {
+    dependencies.push_back(path);
+  }
+
+  includeStack.push_back(path);
+  handleArena(*included);
+  includeStack.pop_back();
+}
+
+// 依次处理另一个词法单元流（被包含的文件或宏展开结果）中的所有行
+void Assembler::handleArena(const TokenArena &arena)
+{
+  if (arenaDepth >= MAX_ARENA_DEPTH)
+  {
+    throw std::runtime_error("Macro or .include nesting too deep");
+  }
+  arenaDepth++;
+  uint32_t savedArena = currentArena;
+  auto it = arenaIndex.find(&arena);
+  if (it == arenaIndex.end())
+  {
+    currentArena = static_cast<uint32_t>(arenas.size());
+    arenaIndex.emplace(&arena, currentArena);
+    arenas.push_back(&arena);
   }
   else
   {
-    instructionResult.insert(instructionResult.end(), machineCode.begin(), machineCode.end());
+    currentArena = it->second;
+  }
+  for (const LexedLine &line : arena.getLines())
+  {
+    handleLine(arena, line);
+  }
+  currentArena = savedArena;
+  arenaDepth--;
+}
+
+// 先相对于当前文件所在目录查找，找不到再按原样（相对于工作目录）使用
+std::string Assembler::resolveInclude(const std::string &name) const
+{
+  if (name.empty() || name[0] == '/' || includeStack.empty())
+  {
+    return name;
+  }
+  const std::string &current = includeStack.back();
+  size_t slash = current.rfind('/');
+  if (slash == std::string::npos)
+  {
+    return name;
+  }
+  std::string candidate = current.substr(0, slash + 1) + name;
+  return access(candidate.c_str(), R_OK) == 0 ? candidate : name;
+}
+
+void Assembler::setDependencyFile(const std::string &path)
+{
+  dependencyFile = path;
+}
+
+// 写出 make 风格的依赖文件：目标依赖于输入和所有被包含的文件，
+// 并为每个被包含的文件生成空规则，头文件被删除时 make 不会报错
+void Assembler::writeDependencyFile(const std::string &inputFile, const std::string &outputFile)
+{
+  if (dependencyFile.empty())
+  {
+    return;
+  }
+  auto escape = [](const std::string &path)
+  {
+    std::string result;
+    for (char c : path)
+    {
+      if (c == ' ' || c == '#')
+      {
+        result += '\\';
+      }
+      else if (c == '$')
+      {
+        result += '$';
+      }
+      result += c;
+    }
+    return result;
+  };
+
+  std::ofstream out(dependencyFile);
+  if (!out)
+  {
+    std::cerr << "无法打开文件 " << dependencyFile << " 进行写入。" << std::endl;
+    return;
+  }
+  out << escape(outputFile) << ":";
+  if (inputFile != "-")
+  {
+    out << " " << escape(inputFile);
+  }
+  for (const std::string &dependency : dependencies)
+  {
+    out << " \\\n  " << escape(dependency);
+  }
+  out << "\n";
+  for (const std::string &dependency : dependencies)
+  {
+    out << "\n" << escape(dependency) << ":\n";
   }
 }
 
@@ -487,9 +1400,8 @@ void Assembler::handleSegmentTable()
 {
   for (const auto &sec : sectionTable)
   {
-    const std::string &secName = sec.first;
     const Section &section = sec.second;
-    const std::string &segmentName = section.getSegmentName();
+    Atom segmentName = section.getSegmentId();
     segSecTable[segmentName].push_back(section);
   }
 }
\ No newline at end of file
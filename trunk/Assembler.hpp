@@ -2,8 +2,10 @@
 #define ASSEMBLER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 #include <iostream>
 #include <fstream>
 #include <cstdint>
@@ -11,53 +13,205 @@
 #include "../symbol_table/SymbolTable.hpp"
 #include "../relocation_table/RelocationTable.hpp"
 #include "../instruction/Instruction.hpp"
+#include "../instruction/EncodeCache.hpp"
+#include "../instruction/BatchEncoder.hpp"
 #include "../section/Section.hpp"
+#include "../utils/SourceBuffer.hpp"
+#include "../lexer/Lexer.hpp"
+#include "../utils/StringPool.hpp"
+#include "../macro/MacroEngine.hpp"
 
 class Assembler
 {
 public:
   void assemble(const std::string &inputFile, const std::string &outputFile, bool);
 
+  // 设置分词线程数（大于 1 时按块并行切行和分词，输出与单线程完全相同）
+  void setLexThreads(unsigned threads);
+
+  // 汇编结束后写出 make 风格的依赖文件（.d）
+  void setDependencyFile(const std::string &path);
+
+  // 流式汇编（仅平坦二进制输出）：内存占用只与未解析的前向引用数量有关，输出文件需可随机写
+  void assembleStream(const std::string &inputFile, const std::string &outputFile);
+
+  // 平坦模式默认一遍扫描：指令第一次出现时就编码，引用未定义标签的字挂到该标签的修补链上，
+  // 标签定义时回填。twoPass 为 true 时改用原来的两遍扫描（先解码全部指令，再统一编码和解析符号），用于对比
+  void setTwoPass(bool twoPass);
+
+  // 使用进程级共享的编码缓存（批量 / 常驻模式下多个文件共用），默认每次汇编独立
+  void setSharedEncodeCache(bool shared);
+
+  // 输出缓存命中统计
+  void printStats(std::ostream &os) const;
+
+  // 符号表中的符号个数（一遍扫描时不含只在函数内使用的 .L 标签）
+  size_t getSymbolCount() const { return symbolTable.size(); }
+
 private:
   void firstPass();
   void secondPass();
   void writeFile(const std::string &outputFile);
-  std::vector<std::string> readAssemblyCode(const std::string &filename);
+  std::vector<std::string_view> readAssemblyCode(const std::string &filename);
   void initializeSegments();
+  void handleLine(const TokenArena &arena, const LexedLine &line);
+
+  // 流式模式
+  void handleStreamLine(std::string_view line);
+
+  // 一遍扫描（流式模式和默认的平坦模式）
+  void emitInstruction(const Instruction &instruction, uint32_t cached);
+  void flushBatch();
+  void handleOnePassInstruction(const Instruction &instruction);
+  void resolvePendingSymbol(SymbolId symbol);
+  void defineLocalLabel(uint32_t number);
+  void defineScratchLabel(Atom label);
+  void closeScratchScope();
+  uint32_t labelAddress(std::string_view name);
+  void setLabelSize(Atom name, int size);
+  bool isFunctionScratchLabel(std::string_view name) const;
+  void patchFixup(uint32_t index, uint32_t bits);
+  void finishOnePass();
+  void writeWords(uint64_t offset, const uint32_t *words, size_t count);
 
 private:
-  void handleTypeDirective(std::istringstream &iss, std::string &currentSecName);
-  void handleGloblDirective(std::istringstream &iss);
-  void handleSectionDirective(std::istringstream &iss, std::string &currentSecName);
-  void handleP2AlignDirective(std::istringstream &iss, const std::string &currentSecName);
-  void handleSizeDirective(std::istringstream &iss, const std::string &currentSecName);
-  void handleWordDirective(std::istringstream &iss, const std::string &currentSecName);
-  void handleAscizDirective(std::istringstream &iss, const std::string &currentSecName);
-  void handleInstruction(const int address, const std::string &line, const std::string &currentSecName);
+  // 伪指令处理，rest 为伪指令名之后的原文
+  void handleTypeDirective(std::string_view rest, Atom &currentSecName);
+  void handleGloblDirective(std::string_view rest);
+  void handleSectionDirective(std::string_view rest, Atom &currentSecName);
+  void handleP2AlignDirective(std::string_view rest, Atom currentSecName);
+  void handleSizeDirective(std::string_view rest, Atom currentSecName);
+  void handleWordDirective(std::string_view rest, Atom currentSecName);
+  void handleAscizDirective(std::string_view rest, Atom currentSecName);
+  void handleIncludeDirective(const TokenArena &arena, const LexedLine &lexed);
+  void handleArena(const TokenArena &arena);
+  std::string resolveInclude(const std::string &name) const;
+  void writeDependencyFile(const std::string &inputFile, const std::string &outputFile);
   void handleSegmentTable();
+  // 所有表都以驻留后的名字编号为键
   // 哈希表1：sec_name -> Section
-  std::unordered_map<std::string, Section> sectionTable;
+  std::unordered_map<Atom, Section> sectionTable;
 
   // 哈希表2：段名 -> vector<Section>
-  std::unordered_map<std::string, std::vector<Section>> segSecTable;
+  std::unordered_map<Atom, std::vector<Section>> segSecTable;
+
+  // 指令所在的行：词法单元流下标（0 为主文件，其余为被包含文件）+ 行下标
+  struct LineRef
+  {
+    uint32_t arena;
+    uint32_t line;
+  };
+
+  // 第一遍解码好的指令，第二遍直接编码；行号只用于追踪输出
+  struct DecodedLine
+  {
+    uint32_t address; // ELF 模式为节内地址，平坦模式为全局地址
+    LineRef line;
+    Instruction instruction;
+    uint32_t cached; // 编码缓存项下标，为 EncodeCache::NO_ENTRY 时第二遍编码
+  };
 
-  std::unordered_map<std::string, std::vector<std::pair<int, std::string>>> instructionTable;
+  void handleInstruction(const DecodedLine &decoded, Atom currentSecName);
+  // 第二遍编码一节（或平坦模式全部）的指令：连续的可批量编码的指令整段交给 BatchEncoder
+  void encodeInstructions(const std::vector<DecodedLine> &lines, Atom currentSecName);
+  void handleInstructionBatch(const DecodedLine *lines, size_t count, Atom currentSecName);
+  static constexpr size_t MIN_BATCH = 8; // 短于一轮 SIMD 的段逐条编码
+  std::string_view lineText(LineRef line) const;
+
+  // 节名 -> 该节的指令（ELF 模式），按出现顺序连续存放
+  std::unordered_map<Atom, std::vector<DecodedLine>> instructionTable;
   // std::unordered_map<std::string, std::vector<std::string>> secSymbolTable;
 
-  std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> baseAddressTable;
-  std::unordered_map<std::string, uint32_t> segAddressTable;
-  std::vector<std::pair<uint32_t, std::string>> instructionVector;
+  std::unordered_map<Atom, std::pair<uint32_t, uint32_t>> baseAddressTable;
+  std::unordered_map<Atom, uint32_t> segAddressTable;
+  std::vector<DecodedLine> instructionVector; // 平坦模式的全部指令
   std::vector<uint32_t> instructionResult;
+  std::vector<uint32_t> wordScratch; // .word / .asciz 解析用的复用缓冲区
+  std::vector<uint8_t> ascizScratch;
   bool isUsingElfWriter = false;
+  unsigned lexThreads = 1;
+  std::ostream *log = &std::cout; // 结果信息；输出到标准输出时改写到标准错误（逐行的追踪见 Trace）
 
   SymbolTable symbolTable;
   RelocationTable relocationTable;
-  std::string currentSecName = "";
-  std::vector<std::string> lines; // 汇编代码的行集合
+  Atom currentSecName = 0;
+  SourceBuffer source; // 映射后的源文件
+  TokenArena tokens;   // 整个文件的词法单元，两遍扫描共用
+  std::vector<const TokenArena *> arenas; // 本次汇编用到的词法单元流，arenas[0] 为 tokens
+  std::unordered_map<const TokenArena *, uint32_t> arenaIndex;
+  uint32_t currentArena = 0;              // 正在处理的词法单元流下标
+  uint32_t arenaDepth = 0;                // 宏展开 / .include 的嵌套层数
+  static constexpr uint32_t MAX_ARENA_DEPTH = 256;
+  MacroEngine macros;
+  EncodeCache ownEncodeCache;
+  EncodeCache *encodeCache = &ownEncodeCache;
+  FixupList fixups;                   // 第二遍编码登记的修补记录，每节（平坦模式为全部）编码完后统一解析
+  InstructionBatch batch;             // 批量编码的字段（复用）
+  std::vector<uint32_t> batchWords;   // ELF 模式下批量编码的结果（复用）
+  std::vector<std::string> includeStack;  // 正在处理的文件（用于相对路径和递归检测）
+  std::vector<std::string> dependencies;  // 被包含过的文件，按首次出现的顺序
+  std::vector<std::shared_ptr<const TokenArena>> includedArenas; // 本次汇编包含的文件，缓存替换旧内容后仍然有效
+  std::string dependencyFile;
   uint32_t saddress = 0;
   uint32_t gaddress = 0;
   uint32_t inSecAddress = 0;
   bool isText = false;
+
+  // 一遍扫描和流式模式的状态
+  static constexpr uint32_t NO_FIXUP = UINT32_MAX;
+  struct PendingFixup
+  {
+    Fixup fixup;
+    uint64_t outputOffset; // 被修补的字在输出中的偏移
+    uint32_t word;         // 已写出的指令模板（立即数字段为 0）
+    uint32_t next;         // 修补链上的下一条，NO_FIXUP 为链尾
+  };
+  // 等待同一个符号的修补记录串成一条链
+  struct FixupChain
+  {
+    uint32_t head;
+    uint32_t tail;
+  };
+  // 数字局部标签（1:、1b、1f）不进符号表：每个编号只记最近一次定义的地址（供 Nb 引用），
+  // 以及等待下一次定义的修补链（Nf 引用）
+  struct LocalLabel
+  {
+    uint32_t address;
+    bool defined;
+    FixupChain forward;
+  };
+  static constexpr uint32_t MAX_LOCAL_LABEL = 1 << 16;
+  void chainFixup(FixupChain &chain, const PendingFixup &pending);
+  LocalLabel &localLabel(uint32_t number);
+  static constexpr size_t STREAM_CHUNK_SIZE = 1 << 16;
+  static constexpr size_t ONE_PASS_BATCH = 256; // 一遍扫描时最多攒多少条指令批量编码
+  bool usingTwoPass = false;
+  bool isOnePass = false;
+  bool isStreaming = false;
+  std::ofstream streamOut;
+  bool streamToStdout = false;
+  std::vector<uint32_t> streamBuffer; // 输出到标准输出时暂存的小端序机器码
+  TokenArena streamTokens; // 当前行的词法单元
+  uint64_t outputOffset = 0;   // 已输出的字节数
+  uint64_t batchOffset = 0;    // 攒着的第一条指令在输出中的偏移
+  FixupList instructionFixups; // 当前指令的修补记录
+  std::vector<PendingFixup> pendingFixups;
+  std::vector<uint32_t> freeFixups;     // 可复用的修补记录下标
+  std::vector<FixupChain> pendingChains; // 符号句柄 -> 等待它的修补链
+  std::vector<LocalLabel> localLabels;   // 编号 -> 数字局部标签
+
+  // 函数内（.type @function 到该函数的 .size 之间）的 .L 标签（.LBB0_1、.Lfunc_end0 等）先放在临时表里：
+  // 函数结束时已定义的只把地址和大小留在 closedLabels 里，仍在等待的引用转给符号表，之后临时表清空。
+  // 这些标签只有在仍未解析的引用用到时才进符号表；函数外的 .L 标签（如 .rodata 中的 .L.str）直接进符号表
+  struct ClosedLabel
+  {
+    uint32_t address; // 全局地址
+    int size;         // .size 设置的大小
+  };
+  SymbolTable scratchSymbols;
+  std::vector<FixupChain> scratchChains;              // 临时表句柄 -> 等待它的修补链
+  std::unordered_map<Atom, ClosedLabel> closedLabels; // 已结束的函数中定义的 .L 标签
+  Atom currentFunction = 0;              // 当前函数（.type 为 @function 且还没有 .size），0 表示不在函数内
 };
 
 #endif // ASSEMBLER_HPP
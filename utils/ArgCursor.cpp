@@ -0,0 +1,57 @@
+// utils/ArgCursor.cpp
+
+#include "ArgCursor.hpp"
+#include "Utils.hpp"
+
+ArgCursor::ArgCursor(std::string_view text, char delimiter)
+    : text(text), delimiter(delimiter)
+{
+}
+
+bool ArgCursor::next(std::string_view &arg)
+{
+  while (pos < text.size())
+  {
+    size_t end = text.find(delimiter, pos);
+    if (end == std::string_view::npos)
+    {
+      end = text.size();
+    }
+    std::string_view piece = Utils::trimView(text.substr(pos, end - pos));
+    pos = end + 1;
+    if (!piece.empty())
+    {
+      arg = piece;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t ArgCursor::count() const
+{
+  ArgCursor copy = *this;
+  size_t n = 0;
+  std::string_view arg;
+  while (copy.next(arg))
+  {
+    n++;
+  }
+  return n;
+}
+
+ParseStatus ArgCursor::parseInt(std::string_view text, int32_t &value)
+{
+  return Utils::parseImmediate(text, value);
+}
+
+std::string_view ArgCursor::firstWord(std::string_view text)
+{
+  size_t start = text.find_first_not_of(" \t\r\n");
+  if (start == std::string_view::npos)
+  {
+    return {};
+  }
+  size_t end = text.find_first_of(" \t\r\n", start);
+  return text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
@@ -0,0 +1,35 @@
+// utils/ArgCursor.hpp
+
+#ifndef ARG_CURSOR_HPP
+#define ARG_CURSOR_HPP
+
+#include <string_view>
+#include <cstdint>
+#include "Utils.hpp"
+
+// 伪指令参数游标：直接在源行上按分隔符切分，返回去除首尾空白的非空片段（与 Utils::split 的结果一致），
+// 整个过程不分配内存
+class ArgCursor
+{
+public:
+  explicit ArgCursor(std::string_view text, char delimiter = ',');
+
+  // 取下一个参数，没有更多参数时返回 false
+  bool next(std::string_view &arg);
+
+  // 剩余参数个数（不移动游标）
+  size_t count() const;
+
+  // 解析整数参数：与指令的立即数相同（Utils::parseImmediate），整个参数必须是字面量
+  static ParseStatus parseInt(std::string_view text, int32_t &value);
+
+  // 返回第一个以空白分隔的单词
+  static std::string_view firstWord(std::string_view text);
+
+private:
+  std::string_view text;
+  size_t pos = 0;
+  char delimiter;
+};
+
+#endif // ARG_CURSOR_HPP
@@ -0,0 +1,267 @@
+// utils/LineScanner.cpp
+
+#include "LineScanner.hpp"
+#include "Utils.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINE_SCANNER_X86 1
+#endif
+
+namespace
+{
+  // 与 Utils::trim 相同的空白字符集合
+  inline bool isBlank(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  // 扫描状态，跨块保持
+  struct ScanState
+  {
+    const char *text;
+    size_t size;
+    std::vector<std::string_view> &lines;
+    size_t lineStart = 0;
+    size_t commentStart = std::string_view::npos; // 当前行注释起点
+    size_t skipEnd = 0;                           // 此前的字符不是事件（被 '\' 转义或在字符字面量中）
+    bool inQuote = false;
+
+    ScanState(const char *text, size_t size, std::vector<std::string_view> &lines)
+        : text(text), size(size), lines(lines)
+    {
+    }
+
+    void emitLine(size_t end)
+    {
+      if (commentStart != std::string_view::npos)
+      {
+        end = commentStart;
+      }
+      size_t begin = lineStart;
+      while (begin < end && isBlank(text[begin]))
+      {
+        begin++;
+      }
+      while (end > begin && isBlank(text[end - 1]))
+      {
+        end--;
+      }
+      if (begin < end)
+      {
+        lines.emplace_back(text + begin, end - begin);
+      }
+    }
+
+    // 字符字面量 'c' 或 '\c' 的结尾（与 Lexer 的切分一致，不跨行）
+    size_t charLiteralEnd(size_t pos) const
+    {
+      size_t i = pos + 1;
+      if (i < size && text[i] == '\\')
+      {
+        i++;
+      }
+      if (i < size && text[i] != '\n')
+      {
+        i++;
+      }
+      if (i < size && text[i] == '\'')
+      {
+        i++;
+      }
+      return i;
+    }
+
+    // 处理一个事件字符：'\n'、'#'、'"'、'\'' 或 '\'
+    void onEvent(size_t pos)
+    {
+      char c = text[pos];
+      if (c == '\n')
+      {
+        emitLine(pos);
+        lineStart = pos + 1;
+        commentStart = std::string_view::npos;
+        inQuote = false;
+        return;
+      }
+      if (commentStart != std::string_view::npos || pos < skipEnd)
+      {
+        return;
+      }
+      if (c == '"')
+      {
+        inQuote = !inQuote;
+      }
+      else if (c == '\'')
+      {
+        if (!inQuote)
+        {
+          skipEnd = charLiteralEnd(pos);
+        }
+      }
+      else if (c == '\\')
+      {
+        if (inQuote)
+        {
+          skipEnd = pos + 2;
+        }
+      }
+      else if (!inQuote)
+      {
+        commentStart = pos;
+      }
+    }
+
+    // 逐字节处理 [from, to)
+    void scalar(size_t from, size_t to)
+    {
+      for (size_t i = from; i < to; i++)
+      {
+        char c = text[i];
+        if (c == '\n' || c == '#' || c == '"' || c == '\'' || c == '\\')
+        {
+          onEvent(i);
+        }
+      }
+    }
+
+    // 按位掩码依次处理块内事件
+    void onMask(size_t base, uint32_t mask)
+    {
+      while (mask != 0)
+      {
+        onEvent(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+      }
+    }
+
+    void finish(size_t size)
+    {
+      if (lineStart < size)
+      {
+        emitLine(size);
+      }
+    }
+  };
+
+#ifdef LINE_SCANNER_X86
+  __attribute__((target("sse2"))) void splitSSE2(ScanState &state, size_t size)
+  {
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i hash = _mm_set1_epi8('#');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i apostrophe = _mm_set1_epi8('\'');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(state.text + i));
+      __m128i events = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, nl), _mm_cmpeq_epi8(block, hash)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+      events = _mm_or_si128(events, _mm_cmpeq_epi8(block, apostrophe));
+      state.onMask(i, static_cast<uint32_t>(_mm_movemask_epi8(events)));
+    }
+    state.scalar(i, size);
+  }
+
+  __attribute__((target("avx2"))) void splitAVX2(ScanState &state, size_t size)
+  {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i hash = _mm256_set1_epi8('#');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i apostrophe = _mm256_set1_epi8('\'');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(state.text + i));
+      __m256i events = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, nl), _mm256_cmpeq_epi8(block, hash)),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+      events = _mm256_or_si256(events, _mm256_cmpeq_epi8(block, apostrophe));
+      state.onMask(i, static_cast<uint32_t>(_mm256_movemask_epi8(events)));
+    }
+    state.scalar(i, size);
+  }
+#endif
+}
+
+LineScanner::Isa LineScanner::detect()
+{
+#ifdef LINE_SCANNER_X86
+  static const Isa isa = __builtin_cpu_supports("avx2") ? Isa::AVX2 : (__builtin_cpu_supports("sse2") ? Isa::SSE2 : Isa::Scalar);
+  return isa;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+void LineScanner::split(std::string_view text, std::vector<std::string_view> &lines)
+{
+  split(text, lines, detect());
+}
+
+void LineScanner::split(std::string_view text, std::vector<std::string_view> &lines, Isa isa)
+{
+  ScanState state(text.data(), text.size(), lines);
+  switch (isa)
+  {
+#ifdef LINE_SCANNER_X86
+  case Isa::AVX2:
+    splitAVX2(state, text.size());
+    break;
+  case Isa::SSE2:
+    splitSSE2(state, text.size());
+    break;
+#endif
+  default:
+    state.scalar(0, text.size());
+    break;
+  }
+  state.finish(text.size());
+}
+
+std::string_view LineScanner::cleanLine(std::string_view line)
+{
+  bool inQuote = false;
+  for (size_t i = 0; i < line.size(); i++)
+  {
+    char c = line[i];
+    if (c == '\\' && inQuote)
+    {
+      i++; // 跳过被转义的字符
+    }
+    else if (c == '"')
+    {
+      inQuote = !inQuote;
+    }
+    else if (c == '\'' && !inQuote)
+    {
+      // 字符字面量 'c' 或 '\c'：跳到字面量的最后一个字符
+      i += i + 1 < line.size() && line[i + 1] == '\\' ? 2 : 1;
+      if (i + 1 < line.size() && line[i + 1] == '\'')
+      {
+        i++;
+      }
+    }
+    else if (c == '#' && !inQuote)
+    {
+      line = line.substr(0, i);
+      break;
+    }
+  }
+  return Utils::trimView(line);
+}
+
+const char *LineScanner::isaName(Isa isa)
+{
+  switch (isa)
+  {
+  case Isa::AVX2:
+    return "avx2";
+  case Isa::SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
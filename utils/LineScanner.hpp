@@ -0,0 +1,35 @@
+// utils/LineScanner.hpp
+
+#ifndef LINE_SCANNER_HPP
+#define LINE_SCANNER_HPP
+
+#include <string_view>
+#include <vector>
+
+// 前端的行切分器：一次扫描完成分行、去注释和去首尾空白。
+// 按块（SSE2 16 字节 / AVX2 32 字节）把换行、'#'、'"'、'\''、'\' 分类成位掩码，
+// 只对这些事件位逐个处理；字符串和字符字面量中的 '#' 不视为注释。
+class LineScanner
+{
+public:
+  enum class Isa
+  {
+    Scalar,
+    SSE2,
+    AVX2
+  };
+
+  // 运行时检测可用的最佳指令集
+  static Isa detect();
+
+  // 切分 text，把非空行（已去除注释和首尾空白）追加到 lines
+  static void split(std::string_view text, std::vector<std::string_view> &lines);
+  static void split(std::string_view text, std::vector<std::string_view> &lines, Isa isa);
+
+  // 处理单独的一行（流式模式使用）
+  static std::string_view cleanLine(std::string_view line);
+
+  static const char *isaName(Isa isa);
+};
+
+#endif // LINE_SCANNER_HPP
@@ -0,0 +1,149 @@
+// utils/RegisterTable.hpp
+
+#ifndef REGISTER_TABLE_HPP
+#define REGISTER_TABLE_HPP
+
+#include <string_view>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 寄存器名（ABI 名、x0-x31、fp）-> 编号。
+// 寄存器名最长 4 个字符，按小端打包成一个 uint32_t 作为键，
+// 在编译期搜索一个乘数使所有键落在互不相同的槽里（完美散列），
+// 查找只需一次乘法加一次整数比较，不分配内存
+class RegisterTable
+{
+public:
+  struct Entry
+  {
+    std::string_view name;
+    uint8_t number;
+  };
+
+  static constexpr Entry entries[] = {
+      {"zero", 0}, {"x0", 0},
+      {"ra", 1}, {"x1", 1},
+      {"sp", 2}, {"x2", 2},
+      {"gp", 3}, {"x3", 3},
+      {"tp", 4}, {"x4", 4},
+      {"t0", 5}, {"x5", 5},
+      {"t1", 6}, {"x6", 6},
+      {"t2", 7}, {"x7", 7},
+      {"s0", 8}, {"fp", 8}, {"x8", 8},
+      {"s1", 9}, {"x9", 9},
+      {"a0", 10}, {"x10", 10},
+      {"a1", 11}, {"x11", 11},
+      {"a2", 12}, {"x12", 12},
+      {"a3", 13}, {"x13", 13},
+      {"a4", 14}, {"x14", 14},
+      {"a5", 15}, {"x15", 15},
+      {"a6", 16}, {"x16", 16},
+      {"a7", 17}, {"x17", 17},
+      {"s2", 18}, {"x18", 18},
+      {"s3", 19}, {"x19", 19},
+      {"s4", 20}, {"x20", 20},
+      {"s5", 21}, {"x21", 21},
+      {"s6", 22}, {"x22", 22},
+      {"s7", 23}, {"x23", 23},
+      {"s8", 24}, {"x24", 24},
+      {"s9", 25}, {"x25", 25},
+      {"s10", 26}, {"x26", 26},
+      {"s11", 27}, {"x27", 27},
+      {"t3", 28}, {"x28", 28},
+      {"t4", 29}, {"x29", 29},
+      {"t5", 30}, {"x30", 30},
+      {"t6", 31}, {"x31", 31},
+  };
+
+  static constexpr size_t COUNT = sizeof(entries) / sizeof(entries[0]);
+  static constexpr size_t MAX_NAME_LENGTH = 4;
+
+  // 查询寄存器编号，不是寄存器名时返回 false
+  static constexpr bool lookup(std::string_view name, uint32_t &number)
+  {
+    if (name.empty() || name.size() > MAX_NAME_LENGTH)
+    {
+      return false;
+    }
+    uint32_t key = pack(name);
+    const Slot &slot = slots[hash(key, multiplier)];
+    if (slot.key != key)
+    {
+      return false;
+    }
+    number = slot.number;
+    return true;
+  }
+
+private:
+  static constexpr size_t SLOT_BITS = 9;
+  static constexpr size_t SLOT_COUNT = size_t(1) << SLOT_BITS;
+
+  // 空槽的 key 为 0：非空名字打包后不可能为 0
+  struct Slot
+  {
+    uint32_t key;
+    uint8_t number;
+  };
+
+  static constexpr uint32_t pack(std::string_view name)
+  {
+    uint32_t key = 0;
+    for (size_t i = 0; i < name.size(); i++)
+    {
+      key |= static_cast<uint32_t>(static_cast<uint8_t>(name[i])) << (8 * i);
+    }
+    return key;
+  }
+
+  static constexpr size_t hash(uint32_t key, uint32_t multiplier)
+  {
+    return (key * multiplier) >> (32 - SLOT_BITS);
+  }
+
+  static constexpr bool isPerfect(uint32_t multiplier)
+  {
+    bool used[SLOT_COUNT] = {};
+    for (const Entry &entry : entries)
+    {
+      size_t slot = hash(pack(entry.name), multiplier);
+      if (used[slot])
+      {
+        return false;
+      }
+      used[slot] = true;
+    }
+    return true;
+  }
+
+  static constexpr uint32_t findMultiplier()
+  {
+    uint32_t multiplier = 0x9E3779B1u;
+    while (!isPerfect(multiplier))
+    {
+      multiplier += 2;
+    }
+    return multiplier;
+  }
+
+  static constexpr std::array<Slot, SLOT_COUNT> buildSlots(uint32_t multiplier)
+  {
+    std::array<Slot, SLOT_COUNT> result{};
+    for (const Entry &entry : entries)
+    {
+      uint32_t key = pack(entry.name);
+      result[hash(key, multiplier)] = Slot{key, entry.number};
+    }
+    return result;
+  }
+
+  // 在类定义完整之后才能调用上面的 constexpr 函数，定义见类外
+  static const uint32_t multiplier;
+  static const std::array<Slot, SLOT_COUNT> slots;
+};
+
+inline constexpr uint32_t RegisterTable::multiplier = RegisterTable::findMultiplier();
+inline constexpr std::array<RegisterTable::Slot, RegisterTable::SLOT_COUNT> RegisterTable::slots = RegisterTable::buildSlots(RegisterTable::multiplier);
+
+#endif // REGISTER_TABLE_HPP
@@ -0,0 +1,106 @@
+// utils/SourceBuffer.cpp
+
+#include "SourceBuffer.hpp"
+#include "LineScanner.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+SourceBuffer::~SourceBuffer()
+{
+  close();
+}
+
+bool SourceBuffer::open(const std::string &filename)
+{
+  close();
+
+  bool isStdin = filename == "-";
+  int fd = isStdin ? STDIN_FILENO : ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED)
+    {
+      // 两遍扫描都是顺序访问，提示内核预读
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(addr);
+      size = st.st_size;
+      mapped = true;
+      if (!isStdin)
+      {
+        ::close(fd);
+      }
+      return true;
+    }
+  }
+
+  // 非普通文件（管道等）或映射失败：按块增量读入，不要求知道总长度
+  bool ok = true;
+  size_t used = 0;
+  for (;;)
+  {
+    if (fallback.size() - used < READ_CHUNK_SIZE)
+    {
+      fallback.resize(std::max(fallback.size() * 2, used + READ_CHUNK_SIZE));
+    }
+    ssize_t n = ::read(fd, &fallback[used], fallback.size() - used);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      ok = n == 0;
+      break;
+    }
+    used += n;
+  }
+  if (!isStdin)
+  {
+    ::close(fd);
+  }
+  fallback.resize(used);
+  data = fallback.data();
+  size = fallback.size();
+  return ok;
+}
+
+void SourceBuffer::close()
+{
+  if (mapped)
+  {
+    munmap(const_cast<char *>(data), size);
+  }
+  data = nullptr;
+  size = 0;
+  mapped = false;
+  fallback.clear();
+  lines.clear();
+}
+
+const std::vector<std::string_view> &SourceBuffer::buildLineIndex()
+{
+  lines.clear();
+  LineScanner::split(getText(), lines);
+  return lines;
+}
+
+std::string_view SourceBuffer::getText() const
+{
+  return std::string_view(data, size);
+}
+
+const std::vector<std::string_view> &SourceBuffer::getLines() const
+{
+  return lines;
+}
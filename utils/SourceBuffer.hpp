@@ -0,0 +1,47 @@
+// utils/SourceBuffer.hpp
+
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// 只读的源文件缓冲区：优先使用 mmap 映射整个文件，
+// 行索引中的每一项都是指向映射区的 string_view，不做逐行拷贝
+class SourceBuffer
+{
+public:
+  SourceBuffer() = default;
+  ~SourceBuffer();
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+  // 打开并映射文件，失败时返回 false；文件名为 "-" 时读取标准输入
+  bool open(const std::string &filename);
+
+  // 释放映射（行索引随之失效）
+  void close();
+
+  // 建立行索引：去除注释和首尾空白，跳过空行（由 LineScanner 完成）
+  const std::vector<std::string_view> &buildLineIndex();
+
+  // 获取整个文件内容
+  std::string_view getText() const;
+
+  // 获取行索引
+  const std::vector<std::string_view> &getLines() const;
+
+private:
+  static constexpr size_t READ_CHUNK_SIZE = 1 << 16;
+
+  const char *data = nullptr;            // 文件内容起始地址
+  size_t size = 0;                       // 文件大小
+  bool mapped = false;                   // data 是否来自 mmap
+  std::string fallback;                  // 无法 mmap 时（如管道）分块读入
+  std::vector<std::string_view> lines;   // 行索引，指向 data
+};
+
+#endif // SOURCE_BUFFER_HPP
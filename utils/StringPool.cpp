@@ -0,0 +1,75 @@
+// utils/StringPool.cpp
+
+#include "StringPool.hpp"
+#include <cstring>
+
+StringPool::StringPool()
+{
+  strings.push_back(std::string_view());
+  index.emplace(std::string_view(), 0);
+}
+
+StringPool &StringPool::instance()
+{
+  static StringPool pool;
+  return pool;
+}
+
+// 把字符串拷贝到块存储中
+std::string_view StringPool::store(std::string_view str)
+{
+  if (str.size() > BLOCK_SIZE / 4)
+  {
+    // 过长的字符串单独分配一块
+    blocks.emplace_back(new char[str.size()]);
+    std::memcpy(blocks.back().get(), str.data(), str.size());
+    return std::string_view(blocks.back().get(), str.size());
+  }
+  if (blockUsed + str.size() > BLOCK_SIZE)
+  {
+    blocks.emplace_back(new char[BLOCK_SIZE]);
+    current = blocks.back().get();
+    blockUsed = 0;
+  }
+  char *dest = current + blockUsed;
+  std::memcpy(dest, str.data(), str.size());
+  blockUsed += str.size();
+  return std::string_view(dest, str.size());
+}
+
+Atom StringPool::intern(std::string_view str)
+{
+  StringPool &pool = instance();
+  auto it = pool.index.find(str);
+  if (it != pool.index.end())
+  {
+    return it->second;
+  }
+  std::string_view stored = pool.store(str);
+  Atom atom = static_cast<Atom>(pool.strings.size());
+  pool.strings.push_back(stored);
+  pool.index.emplace(stored, atom);
+  return atom;
+}
+
+bool StringPool::find(std::string_view str, Atom &atom)
+{
+  StringPool &pool = instance();
+  auto it = pool.index.find(str);
+  if (it == pool.index.end())
+  {
+    return false;
+  }
+  atom = it->second;
+  return true;
+}
+
+std::string_view StringPool::str(Atom atom)
+{
+  return instance().strings[atom];
+}
+
+size_t StringPool::size()
+{
+  return instance().strings.size();
+}
@@ -0,0 +1,46 @@
+// utils/StringPool.hpp
+
+#ifndef STRING_POOL_HPP
+#define STRING_POOL_HPP
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// 驻留字符串的 32 位编号，0 固定表示空字符串
+using Atom = uint32_t;
+
+// 全局字符串驻留池：符号名、节名、段名等每个不同的名字只存一份、只哈希一次，
+// 各个表都以 Atom 作为键
+class StringPool
+{
+public:
+  // 驻留一个字符串，返回其编号（已存在则直接返回）
+  static Atom intern(std::string_view str);
+
+  // 查询字符串的编号，不存在时返回 false 且不插入
+  static bool find(std::string_view str, Atom &atom);
+
+  // 根据编号取回字符串，视图在进程结束前一直有效
+  static std::string_view str(Atom atom);
+
+  // 已驻留的字符串个数
+  static size_t size();
+
+private:
+  StringPool();
+  static StringPool &instance();
+  std::string_view store(std::string_view str);
+
+  static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+  std::unordered_map<std::string_view, Atom> index; // 字符串 -> 编号，键指向 blocks 中的存储
+  std::vector<std::string_view> strings;            // 编号 -> 字符串
+  std::vector<std::unique_ptr<char[]>> blocks;      // 字符存储，按块分配，地址稳定
+  char *current = nullptr;                          // 当前用于小字符串的块
+  size_t blockUsed = BLOCK_SIZE;
+};
+
+#endif // STRING_POOL_HPP
@@ -0,0 +1,135 @@
+// utils/Trace.cpp
+
+#include "Trace.hpp"
+#include "Utils.hpp"
+#include <cstdlib>
+#include <exception>
+#include <unistd.h>
+
+namespace
+{
+  constexpr std::string_view CategoryNames[] = {"lexer", "directive", "encode", "reloc", "elf"};
+  static_assert(sizeof(CategoryNames) / sizeof(CategoryNames[0]) == static_cast<size_t>(TraceCategory::Count), "每个追踪类别都要有名字");
+
+  std::terminate_handler previousTerminate = nullptr;
+
+  // 未捕获的异常终止程序时不会执行 atexit，先写出缓冲再交给原来的处理函数
+  [[noreturn]] void flushAndTerminate()
+  {
+    Trace::flush();
+    if (previousTerminate)
+    {
+      previousTerminate();
+    }
+    std::abort();
+  }
+}
+
+bool Trace::enable(std::string_view categories)
+{
+  size_t start = 0;
+  while (start <= categories.size())
+  {
+    size_t end = categories.find(',', start);
+    if (end == std::string_view::npos)
+    {
+      end = categories.size();
+    }
+    std::string_view name = Utils::trimView(categories.substr(start, end - start));
+    size_t i = 0;
+    for (; i < static_cast<size_t>(TraceCategory::Count); i++)
+    {
+      if (name == "all" || name == CategoryNames[i])
+      {
+        enabledMask |= 1u << i;
+        levels[i] = static_cast<uint8_t>(TraceLevel::Debug);
+        if (name != "all")
+        {
+          break;
+        }
+      }
+    }
+    if (name != "all" && i == static_cast<size_t>(TraceCategory::Count))
+    {
+      return false;
+    }
+    start = end + 1;
+  }
+  install();
+  return true;
+}
+
+bool Trace::setLevel(std::string_view level)
+{
+  TraceLevel value;
+  if (level == "error")
+  {
+    value = TraceLevel::Error;
+  }
+  else if (level == "info")
+  {
+    value = TraceLevel::Info;
+  }
+  else if (level == "debug")
+  {
+    value = TraceLevel::Debug;
+  }
+  else
+  {
+    return false;
+  }
+  for (size_t i = 0; i < static_cast<size_t>(TraceCategory::Count); i++)
+  {
+    if (enabledMask & (1u << i))
+    {
+      levels[i] = static_cast<uint8_t>(value);
+    }
+  }
+  return true;
+}
+
+void Trace::install()
+{
+  static bool installed = false;
+  if (!installed)
+  {
+    installed = true;
+    buffer.reserve(BUFFER_SIZE);
+    std::atexit(flush);
+    previousTerminate = std::set_terminate(flushAndTerminate);
+  }
+}
+
+void Trace::flush()
+{
+  Utils::writeFully(STDERR_FILENO, buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+Trace::Line::Line(TraceCategory category)
+{
+  buffer += '[';
+  buffer += CategoryNames[static_cast<size_t>(category)];
+  buffer += "] ";
+}
+
+Trace::Line::~Line()
+{
+  buffer += '\n';
+  if (buffer.size() >= BUFFER_SIZE)
+  {
+    flush();
+  }
+}
+
+Trace::Line &Trace::Line::operator<<(std::string_view text)
+{
+  buffer += text;
+  return *this;
+}
+
+Trace::Line &Trace::Line::operator<<(char c)
+{
+  buffer += c;
+  return *this;
+}
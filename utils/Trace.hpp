@@ -0,0 +1,110 @@
+// utils/Trace.hpp
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <type_traits>
+#include <cstdint>
+
+// 追踪代码是否编译进程序：默认保留，定义了 NDEBUG 的发布构建中 TRACE 展开为空语句，
+// 参数表达式也不会被求值。可以用 -DASSEMBLER_TRACE=0/1 显式指定
+#ifndef ASSEMBLER_TRACE
+#ifdef NDEBUG
+#define ASSEMBLER_TRACE 0
+#else
+#define ASSEMBLER_TRACE 1
+#endif
+#endif
+
+// 追踪类别，命令行中用小写名字（lexer、directive、encode、reloc、elf）
+enum class TraceCategory : uint8_t
+{
+  Lexer,     // 分词
+  Directive, // 伪指令
+  Encode,    // 指令编码
+  Reloc,     // 重定位项
+  Elf,       // ELF 输出
+  Count
+};
+
+// 追踪级别：开启某个级别时，更低（数值更小）的级别也会输出
+enum class TraceLevel : uint8_t
+{
+  Off,
+  Error,
+  Info,
+  Debug
+};
+
+// 结构化追踪：按类别和级别过滤，输出到带缓冲的标准错误（标准输出可能是目标文件）。
+// 缓冲满、程序退出或因未捕获的异常终止时写出。只在主线程使用
+class Trace
+{
+public:
+  // 开启一组类别："lexer,encode" 或 "all"，名字不认识时返回 false
+  static bool enable(std::string_view categories);
+
+  // 设置已开启类别的级别（error / info / debug，默认 debug），名字不认识时返回 false
+  static bool setLevel(std::string_view level);
+
+  static bool enabled(TraceCategory category, TraceLevel level)
+  {
+    return static_cast<uint8_t>(level) <= levels[static_cast<size_t>(category)];
+  }
+
+  // 把缓冲中的内容写到标准错误
+  static void flush();
+
+  // 一条追踪记录：构造时写入 "[类别] " 前缀，析构时补上换行
+  class Line
+  {
+  public:
+    explicit Line(TraceCategory category);
+    ~Line();
+
+    Line &operator<<(std::string_view text);
+    Line &operator<<(const char *text) { return *this << std::string_view(text); }
+    Line &operator<<(const std::string &text) { return *this << std::string_view(text); }
+    Line &operator<<(char c);
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    Line &operator<<(T value)
+    {
+      char digits[24];
+      std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+      return *this << std::string_view(digits, result.ptr - digits);
+    }
+  };
+
+private:
+  static void install();
+
+  static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+  inline static uint8_t levels[static_cast<size_t>(TraceCategory::Count)] = {};
+  inline static uint8_t enabledMask = 0; // 开启了哪些类别，setLevel 只作用于这些类别
+  inline static std::string buffer;
+};
+
+// TRACE(Encode, Debug, "正在处理指令：" << text)：类别和级别写名字即可，
+// 未开启时只有一次比较，message 不会被求值
+#if ASSEMBLER_TRACE
+#define TRACE(category, level, message)                                       \
+  do                                                                          \
+  {                                                                           \
+    if (Trace::enabled(TraceCategory::category, TraceLevel::level))           \
+    {                                                                         \
+      Trace::Line(TraceCategory::category) << message;                        \
+    }                                                                         \
+  } while (0)
+#else
+#define TRACE(category, level, message) \
+  do                                    \
+  {                                     \
+  } while (0)
+#endif
+
+#endif // TRACE_HPP
@@ -1,78 +1,15 @@
 // utils/utils.cpp
 
 #include "Utils.hpp"
+#include "RegisterTable.hpp"
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <sstream>
 #include <stdexcept>
-
-const std::unordered_map<std::string, uint32_t> Utils::regMap = {
-    // 通用寄存器
-    {"zero", 0},
-    {"x0", 0},
-    {"ra", 1},
-    {"x1", 1},
-    {"sp", 2},
-    {"x2", 2},
-    {"gp", 3},
-    {"x3", 3},
-    {"tp", 4},
-    {"x4", 4},
-    {"t0", 5},
-    {"x5", 5},
-    {"t1", 6},
-    {"x6", 6},
-    {"t2", 7},
-    {"x7", 7},
-    {"s0", 8},
-    {"fp", 8},
-    {"x8", 8},
-    {"s1", 9},
-    {"x9", 9},
-    {"a0", 10},
-    {"x10", 10},
-    {"a1", 11},
-    {"x11", 11},
-    {"a2", 12},
-    {"x12", 12},
-    {"a3", 13},
-    {"x13", 13},
-    {"a4", 14},
-    {"x14", 14},
-    {"a5", 15},
-    {"x15", 15},
-    {"a6", 16},
-    {"x16", 16},
-    {"a7", 17},
-    {"x17", 17},
-    {"s2", 18},
-    {"x18", 18},
-    {"s3", 19},
-    {"x19", 19},
-    {"s4", 20},
-    {"x20", 20},
-    {"s5", 21},
-    {"x21", 21},
-    {"s6", 22},
-    {"x22", 22},
-    {"s7", 23},
-    {"x23", 23},
-    {"s8", 24},
-    {"x24", 24},
-    {"s9", 25},
-    {"x25", 25},
-    {"s10", 26},
-    {"x26", 26},
-    {"s11", 27},
-    {"x27", 27},
-    {"t3", 28},
-    {"x28", 28},
-    {"t4", 29},
-    {"x29", 29},
-    {"t5", 30},
-    {"x30", 30},
-    {"t6", 31},
-    {"x31", 31}};
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 std::string Utils::trim(const std::string &str)
 {
@@ -85,30 +22,157 @@ std::string Utils::trim(const std::string &str)
   return str.substr(first, (last - first + 1));
 }
 
-int32_t Utils::stringToImmediate(const std::string &str)
+std::string_view Utils::trimView(std::string_view str)
+{
+  size_t first = str.find_first_not_of(" \t\n\r");
+  if (first == std::string_view::npos)
+  {
+    return {}; // 全是空白字符
+  }
+  size_t last = str.find_last_not_of(" \t\n\r");
+  return str.substr(first, (last - first + 1));
+}
+
+// 字符字面量的值：'c' 或 '\c'（支持 \n \t \r \0 \\ \' \"）
+static bool parseCharLiteral(std::string_view text, uint64_t &value)
+{
+  if (text.size() == 3 && text[2] == '\'' && text[1] != '\\')
+  {
+    value = static_cast<uint8_t>(text[1]);
+    return true;
+  }
+  if (text.size() != 4 || text[1] != '\\' || text[3] != '\'')
+  {
+    return false;
+  }
+  switch (text[2])
+  {
+  case 'n':
+    value = '\n';
+    return true;
+  case 't':
+    value = '\t';
+    return true;
+  case 'r':
+    value = '\r';
+    return true;
+  case '0':
+    value = 0;
+    return true;
+  case '\\':
+  case '\'':
+  case '"':
+    value = static_cast<uint8_t>(text[2]);
+    return true;
+  default:
+    return false;
+  }
+}
+
+ParseStatus Utils::parseImmediate(std::string_view str, int32_t &value)
 {
-  std::string s = trim(str);
-  try
+  std::string_view text = trimView(str);
+  bool negative = false;
+  if (!text.empty() && (text[0] == '+' || text[0] == '-'))
+  {
+    negative = text[0] == '-';
+    text.remove_prefix(1);
+  }
+  else if (!text.empty() && !std::isdigit(static_cast<unsigned char>(text[0])) && text[0] != '\'')
+  {
+    return ParseStatus::NotNumber;
+  }
+  if (text.empty())
   {
-    if (s.substr(0, 2) == "0x" || s.substr(0, 2) == "0X")
+    return ParseStatus::Invalid;
+  }
+
+  uint64_t magnitude;
+  if (text[0] == '\'')
+  {
+    if (!parseCharLiteral(text, magnitude))
+    {
+      return ParseStatus::Invalid;
+    }
+  }
+  else
+  {
+    // 按前缀确定进制
+    int base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+    {
+      base = 16;
+      text.remove_prefix(2);
+    }
+    else if (text.size() > 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B'))
+    {
+      base = 2;
+      text.remove_prefix(2);
+    }
+    else if (text.size() > 1 && text[0] == '0')
     {
-      // 十六进制数
-      return static_cast<int32_t>(std::stol(s, nullptr, 16));
+      base = 8;
+      text.remove_prefix(1);
     }
-    else
+    const char *end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, magnitude, base);
+    if (ec == std::errc::result_out_of_range)
     {
-      // 十进制数，可能带有正负号
-      return static_cast<int32_t>(std::stol(s, nullptr, 10));
+      return ParseStatus::OutOfRange;
     }
+    if (ec != std::errc() || ptr != end)
+    {
+      return ParseStatus::Invalid;
+    }
+  }
+
+  if (magnitude > 0xFFFFFFFFu)
+  {
+    return ParseStatus::OutOfRange;
+  }
+  uint32_t bits = static_cast<uint32_t>(magnitude);
+  value = static_cast<int32_t>(negative ? 0u - bits : bits);
+  return ParseStatus::Ok;
+}
+
+int32_t Utils::stringToImmediate(std::string_view str)
+{
+  int32_t value;
+  ParseStatus status = parseImmediate(str, value);
+  if (status != ParseStatus::Ok)
+  {
+    throw immediateError(status, str);
+  }
+  return value;
+}
+
+std::runtime_error Utils::immediateError(ParseStatus status, std::string_view str)
+{
+  if (status == ParseStatus::OutOfRange)
+  {
+    return std::runtime_error("Immediate value out of range: " + std::string(trimView(str)));
   }
-  catch (const std::invalid_argument &e)
+  return std::runtime_error("Invalid immediate value: " + std::string(trimView(str)));
+}
+
+bool Utils::parseLocalLabel(std::string_view name, uint32_t &number)
+{
+  if (name.empty() || !std::isdigit(static_cast<unsigned char>(name[0])))
   {
-    throw std::runtime_error("Invalid immediate value: " + s);
+    return false;
   }
-  catch (const std::out_of_range &e)
+  auto [ptr, ec] = std::from_chars(name.data(), name.data() + name.size(), number);
+  return ec == std::errc() && ptr == name.data() + name.size();
+}
+
+bool Utils::parseLocalLabelReference(std::string_view text, uint32_t &number, bool &forward)
+{
+  if (text.size() < 2 || (text.back() != 'b' && text.back() != 'f'))
   {
-    throw std::runtime_error("Immediate value out of range: " + s);
+    return false;
   }
+  forward = text.back() == 'f';
+  return parseLocalLabel(text.substr(0, text.size() - 1), number);
 }
 
 std::vector<uint8_t> Utils::intToBytes(uint32_t value)
@@ -121,19 +185,24 @@ std::vector<uint8_t> Utils::intToBytes(uint32_t value)
   return bytes;
 }
 
-uint32_t Utils::getRegisterNumber(const std::string &regName)
+uint32_t Utils::getRegisterNumber(std::string_view regName)
 {
-  auto it = regMap.find(regName);
-  if (it != regMap.end())
+  uint32_t regNumber;
+  if (RegisterTable::lookup(regName, regNumber))
   {
-    return it->second;
+    return regNumber;
   }
   else
   {
-    throw std::runtime_error("Invalid register name: " + regName);
+    throw std::runtime_error("Invalid register name: " + std::string(regName));
   }
 }
 
+bool Utils::tryGetRegisterNumber(std::string_view regName, uint32_t &regNumber)
+{
+  return RegisterTable::lookup(regName, regNumber);
+}
+
 uint32_t Utils::alignAddress(uint32_t address, uint32_t alignment)
 {
   if (alignment == 0)
@@ -160,30 +229,6 @@ std::vector<std::string> Utils::split(const std::string &str, char delimiter)
   }
   return tokens;
 }
-bool Utils::isNumber(const std::string &str)
-{
-  if (str.empty())
-    return false;
-
-  size_t start = 0;
-  // 检查第一个字符是否为 '+' 或 '-'
-  if (str[0] == '+' || str[0] == '-')
-  {
-    if (str.length() == 1)
-      return false; // 只有一个 '+' 或 '-'，不是数字
-    start = 1;
-  }
-
-  // 检查剩余的字符是否都是数字
-  for (size_t i = start; i < str.length(); ++i)
-  {
-    if (!std::isdigit(str[i]))
-      return false;
-  }
-
-  return true;
-}
-
 // 检查系统是否为小端序
 bool isSystemLittleEndian()
 {
@@ -207,3 +252,43 @@ uint32_t Utils::toLittleEndian(uint32_t value)
            ((value & 0x000000FF) << 24);
   }
 }
+
+uint64_t Utils::hashBytes(std::string_view data)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : data)
+  {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+int Utils::openOutput(const std::string &filename)
+{
+  if (filename == "-")
+  {
+    return STDOUT_FILENO;
+  }
+  return ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+bool Utils::writeFully(int fd, const void *data, size_t size)
+{
+  const char *p = static_cast<const char *>(data);
+  while (size > 0)
+  {
+    ssize_t n = ::write(fd, p, size);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
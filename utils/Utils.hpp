@@ -4,33 +4,68 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
-#include <unordered_map>
+#include <stdexcept>
 
-class Utils
+// 整数字面量的解析结果
+enum class ParseStatus : uint8_t
 {
-private:
-  // 寄存器名称到编号的映射表
-  static const std::unordered_map<std::string, uint32_t> regMap;
+  Ok,
+  NotNumber, // 不以数字、正负号或单引号开头（通常是符号名）
+  Invalid,   // 看起来是数字但格式不对
+  OutOfRange // 超出 32 位
+};
 
+class Utils
+{
 public:
   // 去除字符串首尾的空白字符
   static std::string trim(const std::string &str);
 
-  // 将表示立即数的字符串转换为整数，支持十进制和十六进制格式
-  static int32_t stringToImmediate(const std::string &str);
+  // 去除首尾空白字符，返回原字符串上的视图，不分配内存
+  static std::string_view trimView(std::string_view str);
+
+  // 解析整数字面量：十进制、0x 十六进制、0b 二进制、0 开头的八进制和字符字面量（'a'、'\n'），
+  // 可带正负号，首尾空白忽略，其余部分必须整个是字面量。绝对值不超过 0xFFFFFFFF，按 32 位取值。
+  // 不抛异常，也不分配内存，可以用来试探一个操作数是不是数字
+  static ParseStatus parseImmediate(std::string_view str, int32_t &value);
+
+  // 同 parseImmediate，失败时抛出异常
+  static int32_t stringToImmediate(std::string_view str);
+
+  // 解析失败时的异常
+  static std::runtime_error immediateError(ParseStatus status, std::string_view str);
+
+  // 数字局部标签的定义（去掉冒号后整个是十进制数字，如 "1"），是时给出编号
+  static bool parseLocalLabel(std::string_view name, uint32_t &number);
+
+  // 数字局部标签的引用："Nb" 为向后最近的定义，"Nf" 为向前最近的定义
+  static bool parseLocalLabelReference(std::string_view text, uint32_t &number, bool &forward);
 
   // 将 32 位整数转换为小端序字节序列
   static std::vector<uint8_t> intToBytes(uint32_t value);
 
-  static uint32_t getRegisterNumber(const std::string &regName);
+  // 查询寄存器编号（见 RegisterTable），不是寄存器名时抛异常
+  static uint32_t getRegisterNumber(std::string_view regName);
+
+  // 查询寄存器编号，不是寄存器名时返回 false（不抛异常）
+  static bool tryGetRegisterNumber(std::string_view regName, uint32_t &regNumber);
 
   static uint32_t alignAddress(uint32_t address, uint32_t alignment);
 
   static std::vector<std::string> split(const std::string &str, char delimiter);
-  static bool isNumber(const std::string &str);
   static uint32_t toLittleEndian(uint32_t value);
+
+  // 64 位 FNV-1a 哈希，用于按内容识别文件
+  static uint64_t hashBytes(std::string_view data);
+
+  // 打开输出：文件名为 "-" 时返回标准输出，否则创建/截断文件；失败返回 -1
+  static int openOutput(const std::string &filename);
+
+  // 把整个缓冲区写入 fd（处理管道上的部分写入和 EINTR），失败返回 false
+  static bool writeFully(int fd, const void *data, size_t size);
   template <typename T>
   static void writeBinary(std::ostream &os, const T &value)
   {